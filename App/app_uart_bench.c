@@ -0,0 +1,313 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+#include "uart.h"
+
+/* This program measures the throughput and the interrupt cost of the uart driver.
+
+   Wiring: the TX pin of the TX uart is connected to the RX pin of the RX uart
+   (the same uart: loopback with a jumper between TX and RX, other uart: cross-wired).
+   Every run sends a counter pattern in messages of msglen characters for BENCH_TIME ms
+   with every baud rate of BENCH_BAUDS and every message length of BENCH_MSGLENS.
+   The buffer sizes can not be changed at run time, they are printed in every line
+   (build it again with other TXBUFx_SIZE, RXBUFx_SIZE to compare them).
+
+   Interrupt cost: the main loop reads the DWT cycle counter in a tight loop between the
+   TX filling and the RX reading, the gaps in the readings are the time of the interrupts
+   (sampled, scaled to the whole run, the load of the other interrupts measured without
+   traffic, e.g. SysTick, is subtracted).
+
+   Output (printf, the report is sent between the runs, it can be on a benchmarked uart too):
+   one CSV line per run, the comment lines begin with '#'
+     tx, rx:     TX and RX uart number
+     baud:       baud rate
+     msglen:     message length (characters / uartx_txreserve)
+     txbuf, rxbuf: TX and RX buffer size
+     bytes_s:    received characters / sec
+     eff_pm:     bytes_s / (baud / 10) in permille (8N1)
+     lost:       sent - received characters
+     rxof:       number of the RX buffer overflows (uartx_cbrxof)
+     errors:     number of the pattern errors (overrun, noise, ...)
+     cyc_byte:   interrupt CPU cycles per received character (TX and RX interrupts together)
+     cpu_pm:     CPU load of the uart interrupts in permille
+
+   If you want to benchmark other serial ports, modify BENCH_PAIRS !
+   (Cortex-M3, M4, M7: the DWT cycle counter is needed)
+*/
+
+/* benchmarked uart pairs: TX uart number, TX USART, RX uart number, RX USART
+   (the uart clock is calculated from the baud rate register set by the driver and UARTx_BAUDRATE) */
+#define  BENCH_PAIRS \
+  BENCH_PAIR(1, USART1, 1, USART1)
+
+#define  BENCH_BAUDS     9600, 115200, 230400, 460800, 921600, 1000000, 2000000, 4500000, 10000000
+#define  BENCH_MSGLENS   1, 16, 64
+#define  BENCH_TIME      1000           /* length of one run (ms) */
+#define  BENCH_SLICE     2000           /* length of one sampling window (CPU cycles) */
+
+#if !defined(DWT_CTRL_CYCCNTENA_Msk)
+#error "app_uart_bench: the DWT cycle counter is needed (Cortex-M3, M4, M7)"
+#endif
+
+#if defined(USART_ISR_TC)
+#define  BENCH_TC(u)     ((u)->ISR & USART_ISR_TC)
+#else
+#define  BENCH_TC(u)     ((u)->SR & USART_SR_TC)
+#endif
+
+struct bench_pair {
+  unsigned int txn, rxn;
+  void (*txinit)(void);
+  void (*rxinit)(void);
+  char (*txreserve)(unsigned int len, struct uart_txspan * ts);
+  void (*txcommit)(void);
+  char (*getchar)(char * c);
+  USART_TypeDef * txu, * rxu;
+  unsigned int txbaud, rxbaud;           /* UARTx_BAUDRATE */
+  unsigned int txbuf, rxbuf;
+};
+
+#define  BENCH_PAIR(t, tu, r, ru) \
+  { t, r, uart ## t ## _init, uart ## r ## _init, uart ## t ## _txreserve, uart ## t ## _txcommit, uart ## r ## _getchar, \
+    tu, ru, UART ## t ## _BAUDRATE, UART ## r ## _BAUDRATE, TXBUF ## t ## _SIZE, RXBUF ## r ## _SIZE },
+
+/* volatile because uartx_cbrxof runs in interrupt */
+volatile unsigned int rxof[9];
+
+#define  BENCH_CBRXOF(x)  void uart ## x ## _cbrxof(void) { rxof[x]++; }
+#if defined(UART1_BAUDRATE) && UART1_BAUDRATE > 0
+BENCH_CBRXOF(1)
+#endif
+#if defined(UART2_BAUDRATE) && UART2_BAUDRATE > 0
+BENCH_CBRXOF(2)
+#endif
+#if defined(UART3_BAUDRATE) && UART3_BAUDRATE > 0
+BENCH_CBRXOF(3)
+#endif
+#if defined(UART4_BAUDRATE) && UART4_BAUDRATE > 0
+BENCH_CBRXOF(4)
+#endif
+#if defined(UART5_BAUDRATE) && UART5_BAUDRATE > 0
+BENCH_CBRXOF(5)
+#endif
+#if defined(UART6_BAUDRATE) && UART6_BAUDRATE > 0
+BENCH_CBRXOF(6)
+#endif
+#if defined(UART7_BAUDRATE) && UART7_BAUDRATE > 0
+BENCH_CBRXOF(7)
+#endif
+#if defined(UART8_BAUDRATE) && UART8_BAUDRATE > 0
+BENCH_CBRXOF(8)
+#endif
+
+static unsigned int gap;                /* longer reading gap than this: interrupt */
+
+#if defined(USART_CR1_OVER8)
+#define  BENCH_OVER8     USART_CR1_OVER8
+#define  BENCH_DIV_MIN   8              /* 8x oversampling below 16 (as UARTx_OVER8 = 2) */
+#else
+#define  BENCH_OVER8     0              /* f1: there is no 8x oversampling */
+#define  BENCH_DIV_MIN   16
+#endif
+
+// ----------------------------------------------------------------------------
+/* the divider (clock / baud rate) from the baud rate register (8x oversampling: the fraction is not shifted) */
+static unsigned int bench_div(USART_TypeDef * u)
+{
+  if(u->CR1 & BENCH_OVER8)
+    return ((u->BRR >> 1) & ~7) | (u->BRR & 7);
+  return u->BRR;
+}
+
+// ----------------------------------------------------------------------------
+/* wait for the end of the transmission and set the baud rate register and the oversampling */
+static void bench_brr(USART_TypeDef * u, unsigned int brr, unsigned int over8)
+{
+  HAL_Delay(1);
+  while(!BENCH_TC(u));
+  __disable_irq();                      /* the uart interrupt does not run during the change */
+  u->CR1 &= ~USART_CR1_UE;
+  u->CR1 = (u->CR1 & ~BENCH_OVER8) | over8;
+  u->BRR = brr;
+  u->CR1 |= USART_CR1_UE;
+  __enable_irq();
+}
+
+// ----------------------------------------------------------------------------
+/* set the divider */
+static void bench_div_set(USART_TypeDef * u, unsigned int div)
+{
+  if(div < 16)
+    bench_brr(u, ((div & ~7) << 1) | (div & 7), BENCH_OVER8);
+  else
+    bench_brr(u, div, 0);
+}
+
+// ----------------------------------------------------------------------------
+/* sampling window: the sum of the reading gaps (interrupts) */
+static unsigned int bench_sample(unsigned int * spin)
+{
+  unsigned int s0, prev, now, d, stolen = 0;
+
+  s0 = prev = DWT->CYCCNT;
+  do
+  {
+    now = DWT->CYCCNT;
+    d = now - prev;
+    if(d > gap)
+      stolen += d;
+    prev = now;
+  } while(now - s0 < BENCH_SLICE);
+  *spin += now - s0;
+  return stolen;
+}
+
+// ----------------------------------------------------------------------------
+/* calibration: reading gap without interrupts and the interrupt load without traffic (permille) */
+static unsigned int bench_calib(void)
+{
+  unsigned int i, prev, now, spin = 0;
+  unsigned long long stolen = 0;
+
+  __disable_irq();
+  prev = DWT->CYCCNT;
+  for(i = 0; i < 1000; i++)
+  {
+    now = DWT->CYCCNT;
+    if(now - prev > gap)
+      gap = now - prev;
+    prev = now;
+  }
+  __enable_irq();
+  gap *= 2;
+
+  i = HAL_GetTick();
+  while(HAL_GetTick() - i < 100)
+    stolen += bench_sample(&spin);
+  return (unsigned int)(stolen * 1000 / spin);
+}
+
+// ----------------------------------------------------------------------------
+/* one run */
+static void bench_run(const struct bench_pair * p, unsigned int baud, unsigned int msglen, unsigned int base)
+{
+  struct uart_txspan ts;
+  unsigned int txdiv, rxdiv, txbrr0, rxbrr0, txcr10, rxcr10, i, t0, t, tcyc;
+  unsigned int txcnt = 0, rxcnt = 0, rxend = 0, errors = 0, spin = 0, lastrx, bps;
+  unsigned long long stolen = 0, isr;
+  unsigned char txc = 0, rxc = 0;
+  char c, run = 1;
+
+  if(msglen > p->txbuf)
+  {
+    printf("# %u characters: longer than the TX buffer\r\n", msglen);
+    return;
+  }
+
+  txdiv = ((unsigned long long)bench_div(p->txu) * p->txbaud + baud / 2) / baud;
+  rxdiv = ((unsigned long long)bench_div(p->rxu) * p->rxbaud + baud / 2) / baud;
+  if(txdiv < BENCH_DIV_MIN || rxdiv < BENCH_DIV_MIN)
+  {
+    printf("# %u baud: too high for the uart clock\r\n", baud);
+    return;
+  }
+
+  txbrr0 = p->txu->BRR;
+  rxbrr0 = p->rxu->BRR;
+  txcr10 = p->txu->CR1 & BENCH_OVER8;
+  rxcr10 = p->rxu->CR1 & BENCH_OVER8;
+  bench_div_set(p->txu, txdiv);
+  if(p->rxu != p->txu)
+    bench_div_set(p->rxu, rxdiv);
+  while(p->getchar(&c));                /* e.g. the looped back report */
+  rxof[p->rxn] = 0;
+
+  tcyc = BENCH_TIME * (SystemCoreClock / 1000);
+  t0 = DWT->CYCCNT;
+  lastrx = HAL_GetTick();
+  while(1)
+  {
+    t = DWT->CYCCNT - t0;
+    if(run && t >= tcyc)
+    {                                   /* end of the timed part */
+      run = 0;
+      rxend = rxcnt;
+    }
+
+    if(run)
+      while(p->txreserve(msglen, &ts))
+      {
+        for(i = 0; i < msglen; i++)
+          UART_TXSPAN_PUT(&ts, txc++);
+        p->txcommit();
+        txcnt += msglen;
+      }
+
+    while(p->getchar(&c))
+    {
+      if((unsigned char)c != rxc)
+      {
+        errors++;
+        rxc = c;
+      }
+      rxc++;
+      rxcnt++;
+      lastrx = HAL_GetTick();
+    }
+
+    if(run)
+      stolen += bench_sample(&spin);
+    else if(rxcnt == txcnt || HAL_GetTick() - lastrx > 20)
+      break;                            /* everything is received or the rest is lost */
+  }
+
+  bench_brr(p->txu, txbrr0, txcr10);
+  if(p->rxu != p->txu)
+    bench_brr(p->rxu, rxbrr0, rxcr10);
+
+  /* interrupt cycles: the sampled gaps scaled to the whole run, without the base load */
+  isr = stolen * tcyc / (spin ? spin : 1);
+  i = (unsigned long long)base * tcyc / 1000;
+  isr = (isr > i) ? isr - i : 0;
+
+  bps = (unsigned long long)rxend * 1000 / BENCH_TIME;
+  printf("%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\r\n",
+         p->txn, p->rxn, baud, msglen, p->txbuf, p->rxbuf,
+         bps, (unsigned int)((unsigned long long)bps * 10000 / baud),
+         txcnt - rxcnt, rxof[p->rxn], errors,
+         rxend ? (unsigned int)(isr / rxend) : 0,
+         (unsigned int)(isr * 1000 / tcyc));
+}
+
+// ----------------------------------------------------------------------------
+/* main application */
+void mainApp(void)
+{
+  const struct bench_pair pairs[] = { BENCH_PAIRS };
+  const unsigned int bauds[] = { BENCH_BAUDS };
+  const unsigned int msglens[] = { BENCH_MSGLENS };
+  unsigned int p, b, m, base;
+
+  for(p = 0; p < sizeof(pairs) / sizeof(pairs[0]); p++)
+  {                                     /* before the first use (the baud rate registers are changed) */
+    pairs[p].txinit();
+    if(pairs[p].rxinit != pairs[p].txinit)
+      pairs[p].rxinit();
+  }
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  base = bench_calib();
+
+  printf("\r\n# uart bench: core clock %u Hz, run %u ms, base interrupt load %u permille\r\n",
+         (unsigned int)SystemCoreClock, BENCH_TIME, base);
+  printf("tx,rx,baud,msglen,txbuf,rxbuf,bytes_s,eff_pm,lost,rxof,errors,cyc_byte,cpu_pm\r\n");
+
+  for(p = 0; p < sizeof(pairs) / sizeof(pairs[0]); p++)
+    for(b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++)
+      for(m = 0; m < sizeof(msglens) / sizeof(msglens[0]); m++)
+        bench_run(&pairs[p], bauds[b], msglens[m], base);
+
+  printf("# end\r\n");
+  while(1);
+}
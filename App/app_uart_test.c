@@ -36,6 +36,7 @@ void mainApp(void)
   char ch;
 
   printf("\r\nUart test start\r\n");
+  uart_priority_report();
 
   while(1)
   {
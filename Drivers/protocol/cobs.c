@@ -0,0 +1,115 @@
+/* COBS (Consistent Overhead Byte Stuffing) framing layer for the uart driver */
+
+#include "main.h"
+#include "cobs.h"
+
+/*------------------------------------------------------------------------------
+  decode one received character (err: NZ if receive error)
+ *------------------------------------------------------------------------------*/
+void cobs_rx(struct cobs_rx * d, char c, char err)
+{
+  unsigned char b = (unsigned char)c;
+
+  if(b == 0)
+  {                                     /* frame delimiter */
+    if(d->skip || d->n)
+      uart_frameq_abort(d->q);          /* receive error or truncated block */
+    else
+      uart_frameq_end(d->q);
+    d->code = 0;
+    d->n = 0;
+    d->skip = 0;
+    return;
+  }
+
+  if(d->skip)
+    return;
+
+  if(err)
+  {
+    uart_frameq_abort(d->q);
+    d->skip = 1;
+    return;
+  }
+
+  if(d->n)
+  {                                     /* data character */
+    uart_frameq_put(d->q, (char)b);
+    d->n--;
+  }
+  else
+  {                                     /* code character: the previous block ended with 0 (if it is not 0xFF) */
+    if(d->code && d->code != 0xFF)
+      uart_frameq_put(d->q, 0);
+    d->code = b;
+    d->n = b - 1;
+  }
+}
+
+/*------------------------------------------------------------------------------
+  length of the encoded frame (with the delimiter)
+ *------------------------------------------------------------------------------*/
+unsigned int cobs_enclen(const void * buf, unsigned int len)
+{
+  const unsigned char * p = (const unsigned char *)buf;
+  unsigned int r = len + 2, n = 0;
+
+  while(len--)
+  {
+    if(*p++ == 0)
+      n = 0;
+    else if(++n == 254)
+    {                                   /* full block: one more code character if the frame continues */
+      if(len)
+        r++;
+      n = 0;
+    }
+  }
+  return r;
+}
+
+/*------------------------------------------------------------------------------
+  encode a frame into the reserved TX buffer area (ts: cobs_enclen long)
+ *------------------------------------------------------------------------------*/
+void cobs_encode(struct uart_txspan * ts, const void * buf, unsigned int len)
+{
+  const unsigned char * p = (const unsigned char *)buf;
+  char * cp;                            /* place of the code character of the current block */
+  unsigned char code = 1;
+
+  cp = ts->n1 ? ts->p1 : ts->p2;
+  UART_TXSPAN_PUT(ts, 0);
+  while(len--)
+  {
+    if(*p)
+    {
+      UART_TXSPAN_PUT(ts, (char)*p);
+      code++;
+    }
+    if(!*p || (code == 0xFF && len))
+    {                                   /* close the block, begin the next */
+      *cp = (char)code;
+      cp = ts->n1 ? ts->p1 : ts->p2;
+      UART_TXSPAN_PUT(ts, 0);
+      code = 1;
+    }
+    p++;
+  }
+  *cp = (char)code;
+  UART_TXSPAN_PUT(ts, 0);               /* frame delimiter */
+}
+
+/*------------------------------------------------------------------------------
+  encode a frame directly into the TX buffer of the uart
+  return: 1 = ok, 0 = not sent
+ *------------------------------------------------------------------------------*/
+char cobs_send(const struct uart_txport * port, const void * buf, unsigned int len)
+{
+  struct uart_txspan ts;
+
+  if(!uart_txport_reserve(port, cobs_enclen(buf, len), &ts))
+    return 0;
+  cobs_encode(&ts, buf, len);
+  port->commit();
+  return 1;
+}
@@ -0,0 +1,51 @@
+#ifndef __COBS_H__
+#define __COBS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* COBS (Consistent Overhead Byte Stuffing) framing layer for the uart driver
+
+   Every frame is encoded without 0x00 character and closed with 0x00 (frame delimiter).
+   The overhead is 1 character + 1 character / 254 characters + the delimiter.
+
+   - cobs_rx: decode one received character into the frame queue
+       note: it can be called from uartx_rxhook (in the interrupt) or from the main program (uartx_getchar)
+             e.g. char uart1_rxhook(char rxch, char err) { cobs_rx(&cobs1, rxch, err); return 1; }
+             the complete decoded frames can be read with uart_frameq_get (see uart_proto.h)
+             invalid frames and frames with a receive error are dropped
+
+   - cobs_enclen: length of the encoded frame (with the delimiter)
+
+   - cobs_encode: encode a frame into a reserved TX buffer area (ts must be cobs_enclen long)
+
+   - cobs_send: encode a frame directly into the TX buffer of the uart
+       note: return = 1 -> the frame is in the TX buffer, 0 -> not sent (larger than the TX buffer
+             or the TX buffer is full in interrupt)
+             e.g. const struct uart_txport tx1 = UART_TXPORT(1); cobs_send(&tx1, data, len);
+*/
+
+#include "uart_proto.h"
+
+/* decoder state */
+struct cobs_rx {
+  struct uart_frameq * q;               /* frame queue of the decoded frames */
+  unsigned char code;                   /* code of the current block (0: begin of the frame) */
+  unsigned char n;                      /* remaining characters of the current block */
+  unsigned char skip;                   /* NZ: drop the characters to the next delimiter */
+};
+
+#define  COBS_RX_INIT(q)  { q, 0, 0, 0 }
+
+void     cobs_rx(struct cobs_rx * d, char c, char err);
+unsigned int cobs_enclen(const void * buf, unsigned int len);
+void     cobs_encode(struct uart_txspan * ts, const void * buf, unsigned int len);
+char     cobs_send(const struct uart_txport * port, const void * buf, unsigned int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __COBS_H__ */
@@ -0,0 +1,40 @@
+/* Deferred binary logging for the uart driver */
+
+#include "main.h"
+#include "dlog.h"
+#include "cobs.h"
+
+/*------------------------------------------------------------------------------
+  write a varint (7 bits / character, LSB first)
+ *------------------------------------------------------------------------------*/
+static inline unsigned char * dlog_varint(unsigned char * p, uint32_t v)
+{
+  while(v >= 0x80)
+  {
+    *p++ = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (unsigned char)v;
+  return p;
+}
+
+/*------------------------------------------------------------------------------
+  write one record into the TX buffer
+  return: 1 = the record is in the TX buffer, 0 = lost
+ *------------------------------------------------------------------------------*/
+char dlog_rec(struct dlog * l, const char * fmt, const uint32_t * arg, unsigned int n)
+{
+  unsigned char b[(2 + DLOG_MAXARGS) * 5], * p = b;
+
+  if(n > DLOG_MAXARGS)
+    n = DLOG_MAXARGS;
+  p = dlog_varint(p, (uint32_t)(uintptr_t)fmt);
+  p = dlog_varint(p, l->time ? l->time() : 0);
+  while(n--)
+    p = dlog_varint(p, *arg++);
+
+  if(cobs_send(l->tx, b, p - b))
+    return 1;
+  l->lost++;
+  return 0;
+}
@@ -0,0 +1,76 @@
+#ifndef __DLOG_H__
+#define __DLOG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* Deferred binary logging for the uart driver
+
+   The log message is not formatted on the microcontroller: only a compact record
+   is written into the TX buffer, the host side decoder (Tools/dlog_decode.cpp) formats it
+   with the format string read from the ELF file of the program.
+
+   Record (one COBS frame): format string ID, timestamp, arguments (every value as varint:
+   7 bits / character, LSB first, bit 7 = 1 -> more characters)
+     format string ID: address of the format string (in the .dlog section of the ELF file)
+     timestamp: return value of the time function (e.g. HAL_GetTick), 0 if there is no time function
+
+   - DLOG(l, fmt, ...): log a message (max 8 arguments)
+       note: the arguments are 32 bit integers, characters or pointers (no floating point)
+             %s only with string constants (the decoder reads the string from the ELF file)
+             e.g. DLOG(&log1, "adc ch%u: %d mV", ch, mv);
+
+   - linker script (optional): the format strings do not have to be in the flash, e.g.
+       .dlog 0 (INFO) : { KEEP(*(.dlog)) }
+     without this they are placed in the flash (the decoder works in both cases)
+
+   - struct dlog: logger of one uart
+       note: DLOG_INIT(tx, time): tx: TX port (see uart_proto.h), time: uint32_t time(void) or 0
+*/
+
+#include <stdint.h>
+#include "uart_proto.h"
+
+#define  DLOG_MAXARGS     8
+
+struct dlog {
+  const struct uart_txport * tx;        /* TX port */
+  uint32_t (*time)(void);               /* timestamp (0 = no timestamp) */
+  unsigned int lost;                    /* Number of lost records (TX buffer is full in interrupt) */
+};
+
+#define  DLOG_INIT(tx, time)  { tx, time, 0 }
+
+/* number of the arguments (0..8) */
+#define  DLOG_NARG(...)   DLOG_NARG_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define  DLOG_NARG_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...)  n
+
+/* argument list to 32 bit values */
+#define  DLOG_CAT(a, b)   DLOG_CAT_(a, b)
+#define  DLOG_CAT_(a, b)  a ## b
+#define  DLOG_A0()
+#define  DLOG_A1(a)                          (uint32_t)(uintptr_t)(a)
+#define  DLOG_A2(a, b)                       DLOG_A1(a), DLOG_A1(b)
+#define  DLOG_A3(a, b, c)                    DLOG_A1(a), DLOG_A2(b, c)
+#define  DLOG_A4(a, b, c, d)                 DLOG_A1(a), DLOG_A3(b, c, d)
+#define  DLOG_A5(a, b, c, d, e)              DLOG_A1(a), DLOG_A4(b, c, d, e)
+#define  DLOG_A6(a, b, c, d, e, f)           DLOG_A1(a), DLOG_A5(b, c, d, e, f)
+#define  DLOG_A7(a, b, c, d, e, f, g)        DLOG_A1(a), DLOG_A6(b, c, d, e, f, g)
+#define  DLOG_A8(a, b, c, d, e, f, g, h)     DLOG_A1(a), DLOG_A7(b, c, d, e, f, g, h)
+
+#define  DLOG(l, fmt, ...)                                                    \
+  do {                                                                        \
+    static const char dlog_fmt[] __attribute__((section(".dlog"), used)) = fmt; \
+    const uint32_t dlog_arg[] = { 0, DLOG_CAT(DLOG_A, DLOG_NARG(0, ##__VA_ARGS__))(__VA_ARGS__) }; \
+    dlog_rec(l, dlog_fmt, dlog_arg + 1, sizeof(dlog_arg) / sizeof(dlog_arg[0]) - 1); \
+  } while(0)
+
+char     dlog_rec(struct dlog * l, const char * fmt, const uint32_t * arg, unsigned int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __DLOG_H__ */
@@ -0,0 +1,184 @@
+/* Streaming firmware update receiver */
+
+#include "main.h"
+#include "fwupd.h"
+#include "cobs.h"
+
+static inline uint32_t fwupd_get32(const unsigned char * p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*------------------------------------------------------------------------------
+  add one received character (COBS decoding into the free block buffer)
+ *------------------------------------------------------------------------------*/
+void fwupd_rx(struct fwupd * u, char c, char err)
+{
+  unsigned char b = (unsigned char)c;
+  unsigned int i;
+
+  if(b == 0)
+  {                                     /* frame delimiter */
+    if(u->skip || (u->n && u->left))
+      u->lost++;                        /* receive error, truncated, too long or no free buffer */
+    else if(u->n)
+    {                                   /* complete frame: to fwupd_poll */
+      i = u->cur;
+      u->len[i] = u->n;
+      u->seq[i] = u->fseq++;
+      __DMB();
+      u->full[i] = 1;
+      u->cur = -1;
+    }
+    u->n = 0;
+    u->code = 0;
+    u->left = 0;
+    u->skip = 0;
+    return;
+  }
+
+  if(u->skip)
+    return;
+
+  if(err)
+  {
+    u->skip = 1;
+    return;
+  }
+
+  if(u->cur < 0)
+  {                                     /* begin of the frame: find a free buffer */
+    for(i = 0; i < 2 && u->full[i]; i++);
+    if(i == 2)
+    {                                   /* both blocks are waiting for the programming */
+      u->skip = 1;
+      return;
+    }
+    u->cur = i;
+  }
+
+  if(u->left)
+    u->left--;
+  else
+  {                                     /* code character: the previous block ended with 0 (if it is not 0xFF) */
+    if(u->code && u->code != 0xFF)
+      b = 0;
+    else
+      b = 1;                            /* no data character */
+    u->code = (unsigned char)c;
+    u->left = u->code - 1;
+    if(b)
+      return;
+  }
+
+  if(u->n >= FWUPD_FRAME_MAX)
+  {
+    u->skip = 1;                        /* too long */
+    return;
+  }
+  u->buf[u->cur][FWUPD_PAD + u->n++] = b;
+}
+
+/*------------------------------------------------------------------------------
+  send a frame (with CRC)
+ *------------------------------------------------------------------------------*/
+static void fwupd_send(struct fwupd * u, unsigned char type, uint32_t v, unsigned int vlen)
+{
+  unsigned char f[1 + 4 + 4];
+  uint32_t crc;
+  unsigned int i, n = 0;
+
+  f[n++] = type;
+  for(i = 0; i < vlen; i++)
+    f[n++] = (unsigned char)(v >> (8 * i));
+  crc = ~crc32(UART_CRC32_INIT, f, n);
+  for(i = 0; i < 4; i++)
+    f[n++] = (unsigned char)(crc >> (8 * i));
+  cobs_send(u->tx, f, n);
+}
+
+/*------------------------------------------------------------------------------
+  process one received frame
+ *------------------------------------------------------------------------------*/
+static void fwupd_frame(struct fwupd * u, const unsigned char * f, unsigned int len)
+{
+  uint32_t ofs, size, crc;
+  unsigned int n;
+  char ok;
+
+  if(len < 5 || ~crc32(UART_CRC32_INIT, f, len - 4) != fwupd_get32(f + len - 4))
+  {
+    u->crcerr++;
+    fwupd_send(u, 'K', u->next, 4);     /* send again from the next offset */
+    return;
+  }
+  len -= 4;
+
+  switch(f[0])
+  {
+    case 'Q':
+      fwupd_send(u, 'K', u->next, 4);
+      break;
+
+    case 'D':
+      if(len <= 5)
+        break;
+      ofs = fwupd_get32(f + 1);
+      n = len - 5;
+      if(ofs != u->next)
+      {                                 /* repeated block: dropped, missing block: resume from the next offset */
+        if(ofs > u->next)
+          fwupd_send(u, 'K', u->next, 4);
+        break;
+      }
+      fwupd_send(u, 'K', ofs + n, 4);   /* the next block arrives during the programming */
+      if(u->prog(ofs, (const char *)f + 5, n))
+      {
+        if(!u->image)
+          u->crc = crc32(u->crc, f + 5, n);
+        u->next = ofs + n;
+      }
+      else
+        u->progerr++;                   /* the next block is rejected with the offset of this block */
+      break;
+
+    case 'F':
+      if(len != 9)
+        break;
+      size = fwupd_get32(f + 1);
+      crc = fwupd_get32(f + 5);
+      if(u->next != size)
+      {                                 /* missing blocks (e.g. the programming of the last block failed) */
+        fwupd_send(u, 'K', u->next, 4);
+        break;
+      }
+      ok = crc == (u->image ? ~crc32(UART_CRC32_INIT, u->image, size) : ~u->crc);
+      fwupd_send(u, 'R', ok, 1);
+      if(u->done)
+        u->done(u, ok);
+      break;
+  }
+}
+
+/*------------------------------------------------------------------------------
+  process the received frames in the order of arrival
+ *------------------------------------------------------------------------------*/
+void fwupd_poll(struct fwupd * u)
+{
+  unsigned int i;
+
+  for(;;)
+  {
+    if(u->full[0] && u->full[1])
+      i = ((int)(u->seq[1] - u->seq[0]) < 0) ? 1 : 0;
+    else if(u->full[0])
+      i = 0;
+    else if(u->full[1])
+      i = 1;
+    else
+      return;
+    __DMB();
+    fwupd_frame(u, &u->buf[i][FWUPD_PAD], u->len[i]);
+    u->full[i] = 0;                     /* the buffer is free for the interrupt */
+  }
+}
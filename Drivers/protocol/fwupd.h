@@ -0,0 +1,91 @@
+#ifndef __FWUPD_H__
+#define __FWUPD_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* Streaming firmware update receiver (flash programming overlapped with the reception)
+
+   The received blocks are decoded in the RX interrupt directly into 2 block buffers.
+   When a block is complete, the next offset is acknowledged at once and the block is
+   programmed from the main program (fwupd_poll) while the next block arrives into the other
+   buffer, so the update time is close to the transfer time of the image.
+   The host side sender: Tools/fwupd_send.cpp
+
+   Frames (COBS, every frame ends with CRC-32 little endian, the numbers are little endian):
+     host -> device:
+       'Q':                      query the next offset (start or resume)
+       'D' ofs (4) data (max FWUPD_BLOCK): data block at the offset
+       'F' size (4) crc (4):     finish, image size and CRC-32 of the image
+     device -> host:
+       'K' ofs (4):              send the block at this offset (acknowledge, resume after error)
+       'R' ok (1):               result of the finish (1 = the image is good)
+     Every 'Q', 'D' (except a repeated block) and broken frame is answered with one 'K', so the host
+     sends one block for every 'K' (only one block is in flight). The host sends 'Q' after a timeout
+     (it must be longer than the erase time of a flash sector).
+
+   - fwupd_rx: add one received character (from uartx_rxhook in the interrupt)
+       note: e.g. char uart1_rxhook(char rxch, char err) { fwupd_rx(&fw, rxch, err); return 1; }
+
+   - fwupd_poll: process the received blocks (programming), call it in the main loop
+
+   - callbacks:
+       prog: char prog(uint32_t ofs, const char * buf, unsigned int len): program the flash (1 = ok)
+             note: the erase of the sectors is the task of this function (e.g. at the first block of the sector)
+       done: void done(struct fwupd * u, char ok): the image has been received and verified (optional)
+
+   - image: the image in the memory (the flash is memory mapped), the CRC of the finish is checked on this
+     (0 = the CRC of the programmed blocks is checked, it is only valid without resume after a reset)
+
+   - next: resume offset (e.g. saved or found by the application before the reset, 0 = from the beginning)
+*/
+
+#include <stdint.h>
+#include "uart_proto.h"
+#include "uart_crc.h"
+
+/* block size (the data part of the 'D' frame) */
+#ifndef FWUPD_BLOCK
+#define  FWUPD_BLOCK      1024
+#endif
+
+#define  FWUPD_FRAME_MAX  (1 + 4 + FWUPD_BLOCK + 4)
+#define  FWUPD_PAD        3             /* the frame starts at buf[3]: the data of the 'D' frame is 8 byte aligned */
+
+struct fwupd {
+  const struct uart_txport * tx;        /* TX port */
+  char (*prog)(uint32_t ofs, const char * buf, unsigned int len);
+  void (*done)(struct fwupd * u, char ok);
+  const char * image;                   /* the programmed image in the memory (0 = not readable) */
+  uint32_t next;                        /* next offset to program */
+
+  /* block buffers (written in the interrupt) */
+  unsigned char buf[2][FWUPD_PAD + FWUPD_FRAME_MAX + 4] __attribute__((aligned(8)));
+  volatile unsigned int len[2];         /* length of the received frame */
+  volatile unsigned char full[2];       /* NZ: the buffer holds a complete frame (for fwupd_poll) */
+  volatile unsigned int seq[2];         /* order of the complete frames */
+  unsigned int fseq;                    /* frame counter */
+  signed char cur;                      /* the buffer being filled (-1 = none) */
+  unsigned int n;                       /* length of the open frame */
+  unsigned char code;                   /* COBS code of the current block (0: begin of the frame) */
+  unsigned char left;                   /* remaining characters of the current COBS block */
+  unsigned char skip;                   /* NZ: drop the characters to the next delimiter */
+
+  uint32_t crc;                         /* CRC-32 of the programmed blocks (without resume) */
+  volatile unsigned int lost;           /* Number of dropped frames (no free buffer, too long, receive error) */
+  unsigned int crcerr;                  /* Number of broken frames */
+  unsigned int progerr;                 /* Number of programming errors */
+};
+
+#define  FWUPD_INIT(tx, prog, done, image, next)  { tx, prog, done, image, next, { { 0 } }, { 0 }, { 0 }, { 0 }, 0, -1, 0, 0, 0, 0, UART_CRC32_INIT }
+
+void     fwupd_rx(struct fwupd * u, char c, char err);
+void     fwupd_poll(struct fwupd * u);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __FWUPD_H__ */
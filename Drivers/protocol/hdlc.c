@@ -0,0 +1,102 @@
+/* HDLC-like framing layer with CRC-16/CCITT for the uart driver */
+
+#include "main.h"
+#include "hdlc.h"
+
+/*------------------------------------------------------------------------------
+  decode one received character (err: NZ if receive error)
+ *------------------------------------------------------------------------------*/
+void hdlc_rx(struct hdlc_rx * d, char c, char err)
+{
+  unsigned char b = (unsigned char)c;
+
+  if(b == HDLC_FLAG)
+  {                                     /* end of the frame (or idle fill) */
+    if(uart_frameq_len(d->q) || d->skip)
+    {
+      if(!d->skip && !d->esc && uart_frameq_len(d->q) > 2 && d->crc == UART_CRC16_CCITT_GOOD)
+      {
+        uart_frameq_trim(d->q, 2);      /* without the FCS */
+        uart_frameq_end(d->q);
+      }
+      else
+      {
+        uart_frameq_abort(d->q);
+        d->crcerr++;
+      }
+    }
+    d->crc = UART_CRC16_CCITT_INIT;
+    d->esc = 0;
+    d->skip = 0;
+    return;
+  }
+
+  if(d->skip)
+    return;
+
+  if(err)
+  {
+    uart_frameq_abort(d->q);
+    d->skip = 1;
+    return;
+  }
+
+  if(b == HDLC_ESC)
+  {
+    d->esc = 1;
+    return;
+  }
+  if(d->esc)
+  {
+    d->esc = 0;
+    b ^= HDLC_XOR;
+  }
+  d->crc = crc16_ccitt_byte(d->crc, (char)b);
+  uart_frameq_put(d->q, (char)b);
+}
+
+/*------------------------------------------------------------------------------
+  write one character with stuffing
+ *------------------------------------------------------------------------------*/
+static inline void hdlc_put(struct uart_txspan * ts, unsigned char b)
+{
+  if(b == HDLC_FLAG || b == HDLC_ESC)
+  {
+    UART_TXSPAN_PUT(ts, (char)HDLC_ESC);
+    b ^= HDLC_XOR;
+  }
+  UART_TXSPAN_PUT(ts, (char)b);
+}
+
+/*------------------------------------------------------------------------------
+  stuff and CRC the frame directly into the TX buffer of the uart
+  return: 1 = ok, 0 = not sent
+ *------------------------------------------------------------------------------*/
+char hdlc_send(const struct uart_txport * port, const void * buf, unsigned int len)
+{
+  const unsigned char * p = (const unsigned char *)buf;
+  struct uart_txspan ts;
+  unsigned int i, n = len + 6;          /* FLAG, data, FCS (max 4 with stuffing), FLAG */
+  unsigned short crc = UART_CRC16_CCITT_INIT;
+
+  for(i = 0; i < len; i++)
+    if(p[i] == HDLC_FLAG || p[i] == HDLC_ESC)
+      n++;
+
+  if(!uart_txport_reserve(port, n, &ts))
+    return 0;
+
+  UART_TXSPAN_PUT(&ts, (char)HDLC_FLAG);
+  while(len--)
+  {
+    crc = crc16_ccitt_byte(crc, (char)*p);
+    hdlc_put(&ts, *p++);
+  }
+  crc = ~crc;
+  hdlc_put(&ts, crc & 0xFF);
+  hdlc_put(&ts, crc >> 8);
+  while(ts.n1 + ts.n2)
+    UART_TXSPAN_PUT(&ts, (char)HDLC_FLAG); /* closing FLAG and idle fill */
+  port->commit();
+  return 1;
+}
@@ -0,0 +1,53 @@
+#ifndef __HDLC_H__
+#define __HDLC_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* HDLC-like framing layer with CRC-16/CCITT for the uart driver (asynchronous HDLC, RFC 1662)
+
+   Frame: FLAG (0x7E), data, FCS (CRC-16/CCITT, low byte first), FLAG
+   FLAG and ESC (0x7D) in the data and in the FCS are escaped (ESC, character ^ 0x20).
+   ESC FLAG: the sender aborts the frame.
+
+   - hdlc_rx: decode one received character into the frame queue
+       note: it can be called from uartx_rxhook (in the interrupt) or from the main program (uartx_getchar)
+             e.g. char uart1_rxhook(char rxch, char err) { hdlc_rx(&hdlc1, rxch, err); return 1; }
+             the CRC is updated with every character, so it is known when the closing FLAG arrives:
+             only the good frames are queued (without the FCS), read them with uart_frameq_get
+             the number of dropped frames (CRC error, receive error, abort) is in the crcerr member
+
+   - hdlc_send: stuff and CRC the frame directly into the TX buffer of the uart
+       note: return = 1 -> the frame is in the TX buffer, 0 -> not sent (larger than the TX buffer
+             or the TX buffer is full in interrupt)
+             the unused part of the worst case FCS area is filled with FLAG characters (idle fill)
+*/
+
+#include "uart_proto.h"
+#include "uart_crc.h"
+
+#define  HDLC_FLAG        0x7E
+#define  HDLC_ESC         0x7D
+#define  HDLC_XOR         0x20
+
+/* decoder state */
+struct hdlc_rx {
+  struct uart_frameq * q;               /* frame queue of the good frames */
+  unsigned short crc;                   /* CRC of the open frame */
+  unsigned char esc;                    /* NZ: the previous character was ESC */
+  unsigned char skip;                   /* NZ: drop the characters to the next FLAG */
+  volatile unsigned int crcerr;         /* Number of dropped frames */
+};
+
+#define  HDLC_RX_INIT(q)  { q, UART_CRC16_CCITT_INIT, 0, 0, 0 }
+
+void     hdlc_rx(struct hdlc_rx * d, char c, char err);
+char     hdlc_send(const struct uart_txport * port, const void * buf, unsigned int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __HDLC_H__ */
@@ -0,0 +1,164 @@
+/* Streaming LZSS compressor for the TX direction */
+
+#include <string.h>
+#include "main.h"
+#include "lz.h"
+
+#if (LZ_WINDOW & (LZ_WINDOW - 1)) || LZ_WINDOW > 4096
+#error "LZ_WINDOW must be 2 ^ n and max 4096"
+#endif
+
+/*------------------------------------------------------------------------------
+  hash of 3 characters
+ *------------------------------------------------------------------------------*/
+static inline unsigned int lz_hash(const char * s)
+{
+  return (((unsigned char)s[0] << 5) ^ ((unsigned char)s[1] << 2) ^ (unsigned char)s[2] ^ ((unsigned char)s[0] >> 3)) & (LZ_HASH - 1);
+}
+
+/*------------------------------------------------------------------------------
+  send the open group to the TX buffer
+ *------------------------------------------------------------------------------*/
+static void lz_sendgrp(struct lz_tx * z)
+{
+  struct uart_txspan ts;
+  unsigned int i, n = z->reset ? 3 : 0;
+
+  if(uart_txport_reserve(z->tx, n + z->ngrp, &ts))
+  {
+    if(n)
+    {                                   /* reset group before the group: flag, distance = 0, length field = 1 */
+      UART_TXSPAN_PUT(&ts, (char)0x01);
+      UART_TXSPAN_PUT(&ts, (char)0x00);
+      UART_TXSPAN_PUT(&ts, (char)0x01);
+      z->reset = 0;
+    }
+    for(i = 0; i < z->ngrp; i++)
+      UART_TXSPAN_PUT(&ts, (char)z->grp[i]);
+    z->tx->commit();
+    z->out += n + z->ngrp;
+  }
+  else
+  {                                     /* the decompressor does not have the characters of the group:
+                                           the next match must not refer to the window, restart the stream */
+    z->lost++;
+    z->pos = 0;
+    memset(z->head, 0, sizeof(z->head));
+    z->reset = 1;
+  }
+  z->grp[0] = 0;
+  z->ngrp = 1;
+  z->nitem = 0;
+}
+
+/*------------------------------------------------------------------------------
+  add an item to the open group (n = 1: literal, n = 2: match)
+ *------------------------------------------------------------------------------*/
+static void lz_item(struct lz_tx * z, unsigned char b0, unsigned char b1, unsigned int n)
+{
+  if(n == 2)
+    z->grp[0] |= 1 << z->nitem;
+  z->grp[z->ngrp++] = b0;
+  if(n == 2)
+    z->grp[z->ngrp++] = b1;
+  if(++z->nitem == 8)
+    lz_sendgrp(z);
+}
+
+/*------------------------------------------------------------------------------
+  character at the stream position p (in the window or in the lookahead)
+ *------------------------------------------------------------------------------*/
+static inline char lz_at(const struct lz_tx * z, unsigned int p)
+{
+  return (p < z->pos) ? z->win[p & (LZ_WINDOW - 1)] : z->la[p - z->pos];
+}
+
+/*------------------------------------------------------------------------------
+  move n characters from the lookahead to the window
+ *------------------------------------------------------------------------------*/
+static void lz_advance(struct lz_tx * z, unsigned int n)
+{
+  unsigned int i;
+
+  for(i = 0; i < n; i++)
+  {
+    if(i + LZ_MINMATCH <= z->nla)
+      z->head[lz_hash(&z->la[i])] = (unsigned short)(z->pos + i);
+    z->win[(z->pos + i) & (LZ_WINDOW - 1)] = z->la[i];
+  }
+  z->pos += n;
+  z->nla -= n;
+  memmove(z->la, z->la + n, z->nla);
+}
+
+/*------------------------------------------------------------------------------
+  encode one item from the lookahead
+ *------------------------------------------------------------------------------*/
+static void lz_encode(struct lz_tx * z)
+{
+  unsigned int p, d, n = 0;
+  unsigned char c;
+
+  if(z->nla >= LZ_MINMATCH && z->pos)
+  {                                     /* the last position with the same hash */
+    p = (z->pos & ~0xFFFFu) | z->head[lz_hash(z->la)];
+    if(p >= z->pos)
+      p -= 0x10000;
+    d = z->pos - p;
+    if(d && d < LZ_WINDOW && d <= z->pos)
+      while(n < z->nla && lz_at(z, p + n) == z->la[n])
+        n++;
+  }
+
+  /* the window is updated before the item is added: a lost group resets the whole window */
+  if(n >= LZ_MINMATCH)
+  {
+    lz_advance(z, n);
+    lz_item(z, d & 0xFF, ((d >> 4) & 0xF0) | (n - LZ_MINMATCH), 2);
+  }
+  else
+  {
+    c = (unsigned char)z->la[0];
+    lz_advance(z, 1);
+    lz_item(z, c, 0, 1);
+  }
+}
+
+/*------------------------------------------------------------------------------
+  reset the stream
+ *------------------------------------------------------------------------------*/
+void lz_init(struct lz_tx * z, const struct uart_txport * tx)
+{
+  memset(z, 0, sizeof(*z));
+  z->tx = tx;
+  z->ngrp = 1;
+}
+
+/*------------------------------------------------------------------------------
+  compress characters
+ *------------------------------------------------------------------------------*/
+void lz_write(struct lz_tx * z, const void * buf, unsigned int len)
+{
+  const char * s = (const char *)buf;
+
+  z->in += len;
+  while(len--)
+  {
+    z->la[z->nla++] = *s++;
+    if(z->nla == LZ_MAXMATCH)
+      lz_encode(z);
+  }
+}
+
+/*------------------------------------------------------------------------------
+  send all written characters (the open group is closed with distance = 0)
+ *------------------------------------------------------------------------------*/
+void lz_flush(struct lz_tx * z)
+{
+  while(z->nla)
+    lz_encode(z);
+  if(z->nitem)
+    lz_item(z, 0, 0, 2);                /* end of the group */
+  if(z->nitem)
+    lz_sendgrp(z);                      /* the end marker was not the 8. item */
+}
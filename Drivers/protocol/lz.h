@@ -0,0 +1,76 @@
+#ifndef __LZ_H__
+#define __LZ_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* Streaming LZSS compressor for the TX direction (e.g. log channels)
+
+   The characters are compressed before the TX buffer of the uart with a small window,
+   the RAM usage is fixed (about LZ_WINDOW + 2 * LZ_HASH + 40 bytes per stream).
+   The host side decompressor: Tools/lz_decode.cpp
+
+   Stream: flag character + 8 items, flag bit n (LSB first) = 1 -> the n. item is a match
+     literal: 1 character
+     match:   2 characters: distance bit 0..7, distance bit 8..11 (upper 4 bits) + length - 3 (lower 4 bits)
+              distance = 1..4095 characters back in the uncompressed stream, length = 3..18
+              distance = 0, length field = 0: end of the group (after lz_flush), the next character is a flag character
+              distance = 0, length field = 1: reset, the stream restarts with an empty window (a group was lost),
+                                              the next character is a flag character
+   The stream must be received from the beginning (or from lz_init), the window is kept over lz_flush.
+   A group is sent as a whole or not at all: when the TX buffer is full in interrupt, the group is dropped,
+   the compressor restarts with an empty window and the next group is preceded by the reset group
+   (0x01, 0x00, 0x01), the decompressor continues after the lost characters.
+
+   - lz_write: compress characters (the compressed stream goes to the TX buffer group by group)
+       note: one writer only (not from more interrupts / tasks at the same time)
+
+   - lz_flush: send all characters written so far (e.g. at the end of a log message)
+       note: the latency is bounded by the calling of lz_flush
+
+   - lz_init: reset the stream (the decompressor must be restarted too)
+*/
+
+#include "uart_proto.h"
+
+/* window size (2 ^ n, max 4096) */
+#ifndef LZ_WINDOW
+#define  LZ_WINDOW        1024
+#endif
+
+/* hash table size (2 ^ n) */
+#ifndef LZ_HASH
+#define  LZ_HASH          256
+#endif
+
+#define  LZ_MINMATCH      3
+#define  LZ_MAXMATCH      18
+
+/* compressor state */
+struct lz_tx {
+  const struct uart_txport * tx;        /* TX port */
+  unsigned int pos;                     /* number of compressed characters (position in the stream) */
+  unsigned short head[LZ_HASH];         /* last position of the 3 character hash (lower 16 bits) */
+  char win[LZ_WINDOW];                  /* the last compressed characters */
+  char la[LZ_MAXMATCH];                 /* lookahead */
+  unsigned char nla;                    /* number of characters in the lookahead */
+  unsigned char grp[1 + 8 * 2];         /* the open group (flag + items) */
+  unsigned char ngrp;                   /* length of the open group */
+  unsigned char nitem;                  /* number of items in the open group */
+  unsigned char reset;                  /* 1: the reset group is sent before the next group */
+  unsigned int in;                      /* Number of the uncompressed characters */
+  unsigned int out;                     /* Number of the compressed characters */
+  unsigned int lost;                    /* Number of the groups lost (TX buffer is full in interrupt, the stream is reset) */
+};
+
+void     lz_init(struct lz_tx * z, const struct uart_txport * tx);
+void     lz_write(struct lz_tx * z, const void * buf, unsigned int len);
+void     lz_flush(struct lz_tx * z);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __LZ_H__ */
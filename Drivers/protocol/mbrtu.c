@@ -0,0 +1,203 @@
+/* Modbus RTU frame engine for the uart driver */
+
+#include "main.h"
+#include "mbrtu.h"
+
+/*------------------------------------------------------------------------------
+  add one received character to the open frame (err: NZ if receive error)
+ *------------------------------------------------------------------------------*/
+void mbrtu_rx(struct mbrtu * m, char c, char err)
+{
+  if(err)
+    m->err = 1;
+  m->crc = crc16_modbus_byte(m->crc, c);
+  uart_frameq_put(m->q, c);
+}
+
+/*------------------------------------------------------------------------------
+  end of the frame (3.5 character silence)
+ *------------------------------------------------------------------------------*/
+void mbrtu_gap(struct mbrtu * m)
+{
+  if(uart_frameq_len(m->q))
+  {
+    if(!m->err && m->crc == 0 && uart_frameq_len(m->q) >= 4)
+    {
+      uart_frameq_trim(m->q, 2);        /* without the CRC */
+      uart_frameq_end(m->q);
+    }
+    else
+    {
+      uart_frameq_abort(m->q);
+      m->crcerr++;
+    }
+  }
+  m->crc = UART_CRC16_MODBUS_INIT;
+  m->err = 0;
+}
+
+/*------------------------------------------------------------------------------
+  write one character into the reserved area and update the CRC
+ *------------------------------------------------------------------------------*/
+static inline void mbrtu_put(struct uart_txspan * ts, unsigned short * crc, unsigned char b)
+{
+  *crc = crc16_modbus_byte(*crc, (char)b);
+  UART_TXSPAN_PUT(ts, (char)b);
+}
+
+static inline void mbrtu_putcrc(struct uart_txspan * ts, unsigned short crc)
+{
+  UART_TXSPAN_PUT(ts, (char)(crc & 0xFF));
+  UART_TXSPAN_PUT(ts, (char)(crc >> 8));
+}
+
+/*------------------------------------------------------------------------------
+  send a frame (address, function, data) with CRC
+  return: 1 = ok, 0 = not sent
+ *------------------------------------------------------------------------------*/
+char mbrtu_send(const struct uart_txport * port, const void * buf, unsigned int len)
+{
+  const unsigned char * p = (const unsigned char *)buf;
+  struct uart_txspan ts;
+  unsigned short crc = UART_CRC16_MODBUS_INIT;
+
+  if(!uart_txport_reserve(port, len + 2, &ts))
+    return 0;
+  while(len--)
+    mbrtu_put(&ts, &crc, *p++);
+  mbrtu_putcrc(&ts, crc);
+  port->commit();
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  16 bit value from the frame (big endian)
+ *------------------------------------------------------------------------------*/
+static inline unsigned short mbrtu_get16(const struct uart_frame * f, unsigned int i)
+{
+  return ((unsigned char)uart_frame_at(f, i) << 8) | (unsigned char)uart_frame_at(f, i + 1);
+}
+
+/*------------------------------------------------------------------------------
+  find the register map part of the registers addr..addr+cnt-1
+ *------------------------------------------------------------------------------*/
+static const struct mbrtu_regmap * mbrtu_find(const struct mbrtu_regmap * map, unsigned char type, unsigned int addr, unsigned int cnt)
+{
+  for(; map->count; map++)
+    if(map->type == type && addr >= map->first && addr + cnt <= (unsigned int)map->first + map->count)
+      return map;
+  return 0;
+}
+
+/*------------------------------------------------------------------------------
+  exception response
+ *------------------------------------------------------------------------------*/
+static void mbrtu_exception(struct mbrtu_slave * s, unsigned char fn, unsigned char ex)
+{
+  unsigned char b[3];
+  b[0] = s->addr;
+  b[1] = fn | 0x80;
+  b[2] = ex;
+  mbrtu_send(s->tx, b, 3);
+}
+
+/*------------------------------------------------------------------------------
+  process one received request with the register map
+  return: 1 = a request has been processed, 0 = no request
+ *------------------------------------------------------------------------------*/
+char mbrtu_slave_poll(struct mbrtu_slave * s)
+{
+  struct uart_frame f;
+  struct uart_txspan ts;
+  const struct mbrtu_regmap * rm;
+  unsigned int len, addr, cnt, i;
+  unsigned char dst, fn, ex = 0;
+  unsigned short crc, v;
+
+  if(!uart_frameq_get(s->m->q, &f))
+    return 0;
+
+  len = f.n1 + f.n2;
+  dst = (unsigned char)uart_frame_at(&f, 0);
+  fn = (unsigned char)uart_frame_at(&f, 1);
+  if(dst != s->addr && dst != 0)
+  {                                     /* request to an other slave */
+    uart_frameq_free(s->m->q);
+    return 1;
+  }
+
+  addr = (len >= 6) ? mbrtu_get16(&f, 2) : 0;
+  cnt = (len >= 6) ? mbrtu_get16(&f, 4) : 0;
+  switch(fn)
+  {
+    case 0x03:                          /* read holding registers */
+    case 0x04:                          /* read input registers */
+      if(len != 6 || cnt < 1 || cnt > 125)
+        ex = MBRTU_EX_VALUE;
+      else if(!(rm = mbrtu_find(s->map, (fn == 0x03) ? MBRTU_HOLDING : MBRTU_INPUT, addr, cnt)))
+        ex = MBRTU_EX_ADDRESS;
+      else if(dst && uart_txport_reserve(s->tx, 5 + 2 * cnt, &ts))
+      {                                 /* the response is written directly into the TX buffer */
+        crc = UART_CRC16_MODBUS_INIT;
+        mbrtu_put(&ts, &crc, s->addr);
+        mbrtu_put(&ts, &crc, fn);
+        mbrtu_put(&ts, &crc, 2 * cnt);
+        for(i = 0; i < cnt; i++)
+        {
+          v = rm->read(addr + i);
+          mbrtu_put(&ts, &crc, v >> 8);
+          mbrtu_put(&ts, &crc, v & 0xFF);
+        }
+        mbrtu_putcrc(&ts, crc);
+        s->tx->commit();
+      }
+      break;
+
+    case 0x06:                          /* write single register */
+      if(len != 6)
+        ex = MBRTU_EX_VALUE;
+      else if(!(rm = mbrtu_find(s->map, MBRTU_HOLDING, addr, 1)) || !rm->write)
+        ex = MBRTU_EX_ADDRESS;
+      else if(!rm->write(addr, cnt))
+        ex = MBRTU_EX_FAILURE;
+      else if(dst && uart_txport_reserve(s->tx, 8, &ts))
+      {                                 /* response: echo of the request */
+        crc = UART_CRC16_MODBUS_INIT;
+        for(i = 0; i < 6; i++)
+          mbrtu_put(&ts, &crc, (unsigned char)uart_frame_at(&f, i));
+        mbrtu_putcrc(&ts, crc);
+        s->tx->commit();
+      }
+      break;
+
+    case 0x10:                          /* write multiple registers */
+      if(len < 7 || cnt < 1 || cnt > 123 || (unsigned char)uart_frame_at(&f, 6) != 2 * cnt || len != 7 + 2 * cnt)
+        ex = MBRTU_EX_VALUE;
+      else if(!(rm = mbrtu_find(s->map, MBRTU_HOLDING, addr, cnt)) || !rm->write)
+        ex = MBRTU_EX_ADDRESS;
+      else
+      {
+        for(i = 0; i < cnt && !ex; i++)
+          if(!rm->write(addr + i, mbrtu_get16(&f, 7 + 2 * i)))
+            ex = MBRTU_EX_FAILURE;
+        if(!ex && dst && uart_txport_reserve(s->tx, 8, &ts))
+        {                               /* response: address, function, starting address, quantity */
+          crc = UART_CRC16_MODBUS_INIT;
+          for(i = 0; i < 6; i++)
+            mbrtu_put(&ts, &crc, (unsigned char)uart_frame_at(&f, i));
+          mbrtu_putcrc(&ts, crc);
+          s->tx->commit();
+        }
+      }
+      break;
+
+    default:
+      ex = MBRTU_EX_FUNCTION;
+      break;
+  }
+
+  if(ex && dst)
+    mbrtu_exception(s, fn, ex);
+  uart_frameq_free(s->m->q);
+  return 1;
+}
@@ -0,0 +1,89 @@
+#ifndef __MBRTU_H__
+#define __MBRTU_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* Modbus RTU frame engine for the uart driver
+
+   The end of the frame is the 3.5 character silence, it is detected with the receiver timeout of the uart
+   (uartx_rtoset, uartx_cbrto: hardware RTOR on f0, f3, f7, h7, software timeout on f1, f2, f4).
+   The CRC-16/MODBUS is updated with every received character, only the good frames are queued (without CRC).
+
+   - binding to uart x (e.g. uart1):
+       char uart1_rxhook(char rxch, char err) { mbrtu_rx(&mb1, rxch, err); return 1; }
+       void uart1_cbrto(void) { mbrtu_gap(&mb1); }
+       uart1_rtoset(MBRTU_T35_BITS(19200));
+       note: on f1, f2, f4 uart1_rtopoll must be called periodically (e.g. from a timer interrupt,
+             at least in every 1.5 character time)
+
+   - mbrtu_rx: add one received character to the open frame (from uartx_rxhook or from uartx_getchar)
+
+   - mbrtu_gap: end of the frame (3.5 character silence, from uartx_cbrto)
+       note: the good frames can be read with uart_frameq_get (address, function, data)
+             the number of dropped frames (CRC error, receive error, too short) is in the crcerr member
+
+   - mbrtu_send: send a frame (address, function, data), the CRC is computed into the TX buffer
+
+   - mbrtu_slave_poll: process one received request with the register map (slave)
+       note: return = 1 -> a request has been processed, 0 -> no request in the frame queue
+             supported functions: 0x03 (read holding registers), 0x04 (read input registers),
+             0x06 (write single register), 0x10 (write multiple registers)
+             the response is written directly into the TX buffer, no response to a broadcast (address 0)
+*/
+
+#include "uart_proto.h"
+#include "uart_crc.h"
+
+/* 3.5 character time in bit time (11 bit / character, above 19200 baud: fixed 1750 us) */
+#define  MBRTU_T35_BITS(baud)  ((baud) > 19200 ? (1750UL * (baud) + 999999UL) / 1000000UL : 39)
+
+/* exception codes */
+#define  MBRTU_EX_FUNCTION     0x01     /* illegal function */
+#define  MBRTU_EX_ADDRESS      0x02     /* illegal data address */
+#define  MBRTU_EX_VALUE        0x03     /* illegal data value */
+#define  MBRTU_EX_FAILURE      0x04     /* slave device failure */
+
+/* register types in the register map */
+#define  MBRTU_HOLDING         0        /* read (0x03) and write (0x06, 0x10) */
+#define  MBRTU_INPUT           1        /* read only (0x04) */
+
+/* frame engine state */
+struct mbrtu {
+  struct uart_frameq * q;               /* frame queue of the good frames */
+  unsigned short crc;                   /* CRC of the open frame */
+  unsigned char err;                    /* NZ: receive error in the open frame */
+  volatile unsigned int crcerr;         /* Number of dropped frames */
+};
+
+#define  MBRTU_INIT(q)  { q, UART_CRC16_MODBUS_INIT, 0, 0 }
+
+/* one part of the register map (the last element: count = 0) */
+struct mbrtu_regmap {
+  unsigned char type;                   /* MBRTU_HOLDING or MBRTU_INPUT */
+  unsigned short first;                 /* first register address */
+  unsigned short count;                 /* number of registers */
+  unsigned short (*read)(unsigned short addr);
+  char (*write)(unsigned short addr, unsigned short val); /* return 0: device failure (0 = read only) */
+};
+
+/* slave */
+struct mbrtu_slave {
+  struct mbrtu * m;                     /* frame engine */
+  const struct uart_txport * tx;        /* TX buffer of the uart */
+  unsigned char addr;                   /* slave address (1..247) */
+  const struct mbrtu_regmap * map;      /* register map */
+};
+
+void     mbrtu_rx(struct mbrtu * m, char c, char err);
+void     mbrtu_gap(struct mbrtu * m);
+char     mbrtu_send(const struct uart_txport * port, const void * buf, unsigned int len);
+char     mbrtu_slave_poll(struct mbrtu_slave * s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __MBRTU_H__ */
@@ -0,0 +1,190 @@
+/* NMEA 0183 sentence parser for the uart driver */
+
+#include "main.h"
+#include "nmea.h"
+
+/*------------------------------------------------------------------------------
+  hex character to value (0xFF = not a hex character)
+ *------------------------------------------------------------------------------*/
+static unsigned char nmea_hex(char c)
+{
+  if(c >= '0' && c <= '9')
+    return c - '0';
+  if(c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  if(c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return 0xFF;
+}
+
+/*------------------------------------------------------------------------------
+  add one received character (err: NZ if receive error)
+ *------------------------------------------------------------------------------*/
+void nmea_rx(struct nmea_rx * d, char c, char err)
+{
+  struct nmea_sentence * s;
+  unsigned char h;
+
+  if(c == '$' || c == '!')
+  {                                     /* start of the sentence (also resync after a broken sentence) */
+    if(d->state)
+      d->lost++;
+    if(d->in - d->out >= d->n)
+    {                                   /* the queue is full */
+      d->lost++;
+      d->state = 0;
+      return;
+    }
+    s = &d->s[d->in & (d->n - 1)];
+    s->nfields = 1;
+    s->fofs[0] = 0;
+    d->ck = 0;
+    d->len = 0;
+    d->state = 1;
+    return;
+  }
+
+  if(!d->state)
+    return;                             /* garbage between the sentences */
+
+  s = &d->s[d->in & (d->n - 1)];
+  if(err || c == '\r' || c == '\n')
+  {                                     /* receive error or the sentence ends without checksum */
+    d->lost++;
+    d->state = 0;
+    return;
+  }
+
+  if(d->state == 1)
+  {
+    if(c == '*')
+    {
+      d->state = 2;
+      return;
+    }
+    if(d->len >= NMEA_MAXLEN || (c == ',' && s->nfields >= NMEA_MAXFIELDS))
+    {                                   /* too long */
+      d->lost++;
+      d->state = 0;
+      return;
+    }
+    d->ck ^= (unsigned char)c;
+    s->text[d->len++] = c;
+    if(c == ',')
+      s->fofs[s->nfields++] = d->len;
+    return;
+  }
+
+  h = nmea_hex(c);
+  if(h == 0xFF)
+  {
+    d->ckerr++;
+    d->state = 0;
+    return;
+  }
+  if(d->state == 2)
+  {
+    d->rck = h << 4;
+    d->state = 3;
+    return;
+  }
+
+  d->state = 0;
+  if((d->rck | h) != d->ck)
+  {
+    d->ckerr++;
+    return;
+  }
+  s->text[d->len] = 0;
+  s->fofs[s->nfields] = d->len + 1;
+  __DMB();                              /* the sentence is in the slot before publishing */
+  d->in++;                              /* valid sentence */
+}
+
+/*------------------------------------------------------------------------------
+  get the oldest sentence (0 = no sentence)
+ *------------------------------------------------------------------------------*/
+const struct nmea_sentence * nmea_get(struct nmea_rx * d)
+{
+  if(d->in == d->out)
+    return 0;
+  __DMB();
+  return &d->s[d->out & (d->n - 1)];
+}
+
+/*------------------------------------------------------------------------------
+  release the oldest sentence
+ *------------------------------------------------------------------------------*/
+void nmea_free(struct nmea_rx * d)
+{
+  if(d->in != d->out)
+    d->out++;
+}
+
+/*------------------------------------------------------------------------------
+  i-th field of the sentence
+ *------------------------------------------------------------------------------*/
+const char * nmea_field(const struct nmea_sentence * s, unsigned int i, unsigned int * len)
+{
+  if(i >= s->nfields)
+  {
+    *len = 0;
+    return "";
+  }
+  *len = s->fofs[i + 1] - s->fofs[i] - 1;
+  return &s->text[s->fofs[i]];
+}
+
+/*------------------------------------------------------------------------------
+  compare the sentence formatter (e.g. "GGA"), the talker id is skipped
+  return: 1 = equal, 0 = not equal
+ *------------------------------------------------------------------------------*/
+char nmea_type(const struct nmea_sentence * s, const char * type)
+{
+  unsigned int len, i = 0;
+  const char * f = nmea_field(s, 0, &len);
+
+  if(len >= 1 && f[0] == 'P')
+    i = 1;                              /* proprietary sentence (one character prefix) */
+  else if(len >= 2)
+    i = 2;                              /* talker id */
+  for(; i < len && *type; i++, type++)
+    if(f[i] != *type)
+      return 0;
+  return i == len && !*type;
+}
+
+/*------------------------------------------------------------------------------
+  decimal field to scaled integer
+ *------------------------------------------------------------------------------*/
+long nmea_dec(const struct nmea_sentence * s, unsigned int i, unsigned int decimals)
+{
+  unsigned int len;
+  const char * f = nmea_field(s, i, &len);
+  const char * e = f + len;
+  long v = 0;
+  char neg = 0, frac = 0;
+
+  if(f < e && (*f == '-' || *f == '+'))
+    neg = (*f++ == '-');
+  for(; f < e; f++)
+  {
+    if(*f == '.')
+    {
+      frac = 1;
+      continue;
+    }
+    if(*f < '0' || *f > '9')
+      break;
+    if(frac)
+    {
+      if(!decimals)
+        break;
+      decimals--;
+    }
+    v = v * 10 + (*f - '0');
+  }
+  while(decimals--)
+    v *= 10;
+  return neg ? -v : v;
+}
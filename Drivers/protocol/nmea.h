@@ -0,0 +1,81 @@
+#ifndef __NMEA_H__
+#define __NMEA_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* NMEA 0183 sentence parser for the uart driver
+
+   Sentence: $<address>,<field>,...,<field>*hh<CR><LF> (or !... e.g. AIS)
+   The checksum (xor of the characters between '$' and '*') is calculated while the characters
+   arrive, the field boundaries (commas) are recorded at the same time. Only the sentences with
+   a valid checksum are queued, the fields are read from the queued sentence without copying.
+
+   - nmea_rx: add one received character (from uartx_rxhook in the interrupt or from uartx_getchar)
+       note: e.g. char uart1_rxhook(char rxch, char err) { nmea_rx(&gps, rxch, err); return 1; }
+             sentences without checksum, with receive error or longer than NMEA_MAXLEN are dropped
+
+   - nmea_get: get the oldest sentence
+       note: if return = 0 -> no sentence received (not block the program from running)
+             if return != 0 -> pointer to the sentence, after processing it must be released with nmea_free
+
+   - nmea_field: pointer to the i-th field (0 = address field, e.g. "GPGGA") and the length of the field
+       note: the field is not zero terminated (it ends with ',' or with the end of the sentence)
+             if i >= number of fields -> return = empty string, length = 0
+
+   - nmea_type: compare the sentence formatter (the address field without the talker id, e.g. "GGA")
+
+   - nmea_dec: decimal field to scaled integer (e.g. "4807.038", 3 decimals -> 4807038)
+       note: the missing decimals are filled with zero, the more decimals are truncated
+*/
+
+#include "uart_proto.h"
+
+/* max length of the sentence between '$' and '*' (NMEA 0183: 82 with '$', "*hh" and <CR><LF>) */
+#ifndef NMEA_MAXLEN
+#define  NMEA_MAXLEN      80
+#endif
+
+/* max number of fields (with the address field) */
+#ifndef NMEA_MAXFIELDS
+#define  NMEA_MAXFIELDS   32
+#endif
+
+/* one received sentence */
+struct nmea_sentence {
+  char text[NMEA_MAXLEN + 1];           /* characters between '$' and '*' (zero terminated) */
+  unsigned char nfields;                /* number of fields */
+  unsigned char fofs[NMEA_MAXFIELDS + 1]; /* start of the fields (fofs[nfields] = end of the sentence + 1) */
+};
+
+/* parser state and sentence queue */
+struct nmea_rx {
+  struct nmea_sentence * s;             /* sentence slots */
+  unsigned int n;                       /* number of sentence slots (2 ^ n) */
+  volatile unsigned int in;             /* Next In Sentence */
+  volatile unsigned int out;            /* Next Out Sentence */
+  unsigned char state;                  /* 0 = wait for '$', 1 = sentence, 2, 3 = checksum characters */
+  unsigned char ck;                     /* calculated checksum */
+  unsigned char rck;                    /* received checksum */
+  unsigned char len;                    /* length of the open sentence */
+  volatile unsigned int lost;           /* Number of dropped sentences (too long, receive error, queue full) */
+  volatile unsigned int ckerr;          /* Number of sentences with checksum error */
+};
+
+/* slots: struct nmea_sentence array [number of slots (2 ^ n)] */
+#define  NMEA_RX_INIT(slots)  { slots, sizeof(slots) / sizeof(slots[0]), 0, 0, 0, 0, 0, 0, 0, 0 }
+
+void     nmea_rx(struct nmea_rx * d, char c, char err);
+const struct nmea_sentence * nmea_get(struct nmea_rx * d);
+void     nmea_free(struct nmea_rx * d);
+const char * nmea_field(const struct nmea_sentence * s, unsigned int i, unsigned int * len);
+char     nmea_type(const struct nmea_sentence * s, const char * type);
+long     nmea_dec(const struct nmea_sentence * s, unsigned int i, unsigned int decimals);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __NMEA_H__ */
@@ -0,0 +1,233 @@
+/* Length-prefixed binary packet assembler for the uart driver */
+
+#include <string.h>
+#include "main.h"
+#include "pkt.h"
+#include "uart_crc.h"
+
+/*------------------------------------------------------------------------------
+  length of the checksum
+ *------------------------------------------------------------------------------*/
+static unsigned int pkt_cklen(unsigned char cktype)
+{
+  if(cktype == PKT_CK_SUM8 || cktype == PKT_CK_XOR8)
+    return 1;
+  if(cktype == PKT_CK_CRC16_CCITT || cktype == PKT_CK_CRC16_MODBUS)
+    return 2;
+  if(cktype == PKT_CK_CRC32)
+    return 4;
+  return 0;
+}
+
+/*------------------------------------------------------------------------------
+  read a 1, 2 or 4 character wide field
+ *------------------------------------------------------------------------------*/
+static uint32_t pkt_field(const char * s, unsigned int width, unsigned char bigendian)
+{
+  const unsigned char * u = (const unsigned char *)s;
+  uint32_t v = 0;
+  unsigned int i;
+  for(i = 0; i < width; i++)
+    v |= (uint32_t)u[i] << (8 * (bigendian ? width - 1 - i : i));
+  return v;
+}
+
+/*------------------------------------------------------------------------------
+  check the last character of the open packet
+  return: 0 = the open packet is invalid
+ *------------------------------------------------------------------------------*/
+static char pkt_check(struct pkt_rx * p)
+{
+  const struct pkt_cfg * c = p->cfg;
+  unsigned int i = p->n - 1;
+  int l;
+
+  if(i < c->synclen)
+    return p->cur[i] == c->sync[i];
+
+  if(p->n == c->lenofs + c->lenwidth)
+  {                                     /* the length field is complete */
+    l = (int)pkt_field(&p->cur[c->lenofs], c->lenwidth, c->bigendian) + c->lenadj;
+    if(l < (int)(c->lenofs + c->lenwidth + pkt_cklen(c->cktype)) || l < (int)c->ckofs || l > (int)p->slotsize)
+      return 0;
+    p->len = l;
+  }
+  return !p->len || p->n <= p->len;
+}
+
+/*------------------------------------------------------------------------------
+  check the checksum of the complete packet
+ *------------------------------------------------------------------------------*/
+static char pkt_cksum(struct pkt_rx * p)
+{
+  const struct pkt_cfg * c = p->cfg;
+  unsigned int i, e = p->len - pkt_cklen(c->cktype);
+  unsigned short s = 0;
+
+  switch(c->cktype)
+  {
+    case PKT_CK_SUM8:
+      for(i = c->ckofs; i < e; i++)
+        s += (unsigned char)p->cur[i];
+      return (unsigned char)s == (unsigned char)p->cur[e];
+    case PKT_CK_XOR8:
+      for(i = c->ckofs; i < e; i++)
+        s ^= (unsigned char)p->cur[i];
+      return (unsigned char)s == (unsigned char)p->cur[e];
+    case PKT_CK_CRC16_CCITT:
+      s = ~crc16_ccitt(UART_CRC16_CCITT_INIT, &p->cur[c->ckofs], e - c->ckofs);
+      return s == pkt_field(&p->cur[e], 2, c->bigendian);
+    case PKT_CK_CRC16_MODBUS:
+      s = crc16_modbus(UART_CRC16_MODBUS_INIT, &p->cur[c->ckofs], e - c->ckofs);
+      return s == pkt_field(&p->cur[e], 2, c->bigendian);
+    case PKT_CK_CRC32:
+      return ~crc32(UART_CRC32_INIT, &p->cur[c->ckofs], e - c->ckofs) == pkt_field(&p->cur[e], 4, c->bigendian);
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  find a free slot
+  return: 0 = all slots are kept by the application
+ *------------------------------------------------------------------------------*/
+static char * pkt_slot(struct pkt_rx * p)
+{
+  unsigned int i;
+  for(i = 0; i < p->nslots && p->busy[i]; i++);
+  return (i < p->nslots) ? p->pool + i * p->slotsize : 0;
+}
+
+/*------------------------------------------------------------------------------
+  deliver the complete packet of the open slot to the callback
+  - rest: number of the received characters after the packet (they are moved into a new slot)
+  return: number of the characters in the new slot (0 if there is no free slot)
+ *------------------------------------------------------------------------------*/
+static unsigned int pkt_done(struct pkt_rx * p, unsigned int rest)
+{
+  char * s = p->cur;
+  unsigned int len = p->len, i = (s - p->pool) / p->slotsize;
+
+  p->busy[i] = 1;
+  p->cur = 0;
+  p->n = 0;
+  p->len = 0;
+  if(rest)
+  {
+    p->cur = pkt_slot(p);
+    if(p->cur)
+      memcpy(p->cur, s + len, rest);
+    else
+    {
+      p->lost++;
+      rest = 0;
+    }
+  }
+  if(p->cb(p, s, len))
+    p->busy[i] = 0;                     /* processed in the callback */
+  return rest;
+}
+
+/*------------------------------------------------------------------------------
+  the open packet is invalid: search the next sync pattern in the received characters
+  (a valid packet behind the garbage is delivered, then the search continues after it)
+ *------------------------------------------------------------------------------*/
+static void pkt_resync(struct pkt_rx * p)
+{
+  unsigned int k = 1, m, n = p->n;
+  char ok = 0;
+
+  p->lost++;
+  while(n > k)
+  {
+    for(; k < n && p->cur[k] != p->cfg->sync[0]; k++);
+    if(k == n)
+      break;                            /* there is no more sync character */
+    n -= k;
+    memmove(p->cur, p->cur + k, n);
+    p->n = 0;
+    p->len = 0;
+    for(m = 0; m < n; m++)
+    {
+      p->n++;
+      if(!(ok = pkt_check(p)) || (p->len && p->n == p->len))
+        break;                          /* invalid or complete */
+    }
+    if(m == n)
+      return;                           /* the rest is the beginning of a packet */
+    if(ok && pkt_cksum(p))
+    {                                   /* a complete packet inside the received characters */
+      n = pkt_done(p, n - p->n);
+      k = 0;
+    }
+    else
+      k = 1;
+  }
+  p->n = 0;
+  p->len = 0;
+}
+
+/*------------------------------------------------------------------------------
+  add one received character (err: NZ if receive error)
+ *------------------------------------------------------------------------------*/
+void pkt_rx(struct pkt_rx * p, char c, char err)
+{
+  if(err)
+  {
+    if(p->n)
+      p->lost++;
+    p->n = 0;
+    p->len = 0;
+    return;
+  }
+
+  if(!p->n && c != p->cfg->sync[0])
+    return;                             /* garbage between the packets */
+
+  if(!p->cur && !(p->cur = pkt_slot(p)))
+  {
+    p->lost++;                          /* all slots are kept by the application */
+    return;
+  }
+
+  if(p->n >= p->slotsize)
+  {                                     /* the slot is smaller than the header (see PKT_CHECK) */
+    p->lost++;
+    p->n = 0;
+    p->len = 0;
+    return;
+  }
+
+  p->cur[p->n++] = c;
+  if(!pkt_check(p))
+  {
+    pkt_resync(p);
+    return;
+  }
+
+  if(p->len && p->n == p->len)
+  {                                     /* complete packet */
+    if(!pkt_cksum(p))
+    {
+      pkt_resync(p);
+      return;
+    }
+    pkt_done(p, 0);
+  }
+}
+
+/*------------------------------------------------------------------------------
+  add a block of received characters
+ *------------------------------------------------------------------------------*/
+void pkt_rxblock(struct pkt_rx * p, const char * buf, unsigned int len)
+{
+  while(len--)
+    pkt_rx(p, *buf++, 0);
+}
+
+/*------------------------------------------------------------------------------
+  release a slot kept by the application
+ *------------------------------------------------------------------------------*/
+void pkt_free(struct pkt_rx * p, char * pkt)
+{
+  p->busy[(pkt - p->pool) / p->slotsize] = 0;
+}
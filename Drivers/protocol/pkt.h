@@ -0,0 +1,92 @@
+#ifndef __PKT_H__
+#define __PKT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* Length-prefixed binary packet assembler for the uart driver
+
+   Packet: sync pattern, ..., length field, ..., checksum (the layout is set in struct pkt_cfg)
+   The packets are assembled directly into a pool of fixed size slots, one callback is called
+   for every valid packet. After an invalid length or checksum the already received characters
+   are searched for the next sync pattern (fast resync after garbage), a valid packet found
+   among them is delivered.
+
+   - struct pkt_cfg: packet layout
+       sync, synclen: sync pattern (at the beginning of the packet)
+       lenofs, lenwidth: offset (from the beginning of the packet) and width (1 or 2) of the length field
+       bigendian: byte order of the length field and the checksum (0 = little endian, 1 = big endian)
+       lenadj: packet length = value of the length field + lenadj (e.g. header and checksum length)
+       cktype: checksum type (PKT_CK_...)
+       ckofs: the checksum is calculated from this offset to the checksum (the checksum is at the end)
+
+   - pkt_rx: add one received character (from uartx_rxhook in the interrupt or from uartx_getchar)
+       note: e.g. char uart1_rxhook(char rxch, char err) { pkt_rx(&pkt1, rxch, err); return 1; }
+
+   - pkt_rxblock: add a block of received characters (e.g. DMA block)
+
+   - callback: char cb(struct pkt_rx * p, char * pkt, unsigned int len)
+       note: if return = 1 -> the packet has been processed, the slot is free
+             if return = 0 -> the slot is kept, release it with pkt_free when the packet has been processed
+             attention, it will be operated from an interruption (if pkt_rx is called from the interrupt)!
+
+   - pkt_free: release a kept slot
+
+   - PKT_CHECK: compile time check of the slot size (the header up to the length field must fit in a slot)
+       note: e.g. PKT_CHECK(pool1, 2, 1); (pool, lenofs, lenwidth)
+             at run time a too small slot is not overflowed, but every packet is dropped
+*/
+
+#include "uart_proto.h"
+
+/* checksum types */
+#define  PKT_CK_NONE          0
+#define  PKT_CK_SUM8          1         /* 8 bit sum */
+#define  PKT_CK_XOR8          2         /* 8 bit xor */
+#define  PKT_CK_CRC16_CCITT   3         /* CRC-16/CCITT (X.25, see uart_crc.h) */
+#define  PKT_CK_CRC16_MODBUS  4         /* CRC-16/MODBUS (see uart_crc.h) */
+#define  PKT_CK_CRC32         5         /* CRC-32 (see uart_crc.h) */
+
+/* packet layout */
+struct pkt_cfg {
+  const char * sync;                    /* sync pattern */
+  unsigned char synclen;                /* length of the sync pattern (1..) */
+  unsigned char lenofs;                 /* offset of the length field (>= synclen) */
+  unsigned char lenwidth;               /* width of the length field (1 or 2) */
+  unsigned char bigendian;              /* byte order of the length field and the checksum */
+  int lenadj;                           /* packet length = length field + lenadj */
+  unsigned char cktype;                 /* checksum type */
+  unsigned char ckofs;                  /* first character of the checksum calculation */
+};
+
+/* assembler state */
+struct pkt_rx {
+  const struct pkt_cfg * cfg;           /* packet layout */
+  char * pool;                          /* slots */
+  unsigned int slotsize;                /* slot size (max packet length) */
+  unsigned int nslots;                  /* number of slots */
+  volatile unsigned char * busy;        /* NZ: the slot is kept by the application */
+  char (*cb)(struct pkt_rx * p, char * pkt, unsigned int len);
+  char * cur;                           /* slot of the open packet (0 = no slot) */
+  unsigned int n;                       /* number of characters in the open packet */
+  unsigned int len;                     /* length of the open packet (0 = the length field is not received) */
+  volatile unsigned int lost;           /* Number of invalid or dropped packets */
+};
+
+/* pool: char array [number of slots][slot size], busy: volatile unsigned char array [number of slots] */
+#define  PKT_RX_INIT(cfg, pool, busy, cb)  { cfg, (char *)pool, sizeof(pool[0]), sizeof(pool) / sizeof(pool[0]), busy, cb, 0, 0, 0, 0 }
+
+/* pool: the pool of PKT_RX_INIT, lenofs, lenwidth: the constants of struct pkt_cfg */
+#define  PKT_CHECK(pool, lenofs, lenwidth)  _Static_assert(sizeof(pool[0]) >= (lenofs) + (lenwidth), "pkt: the slot is smaller than the header")
+
+void     pkt_rx(struct pkt_rx * p, char c, char err);
+void     pkt_rxblock(struct pkt_rx * p, const char * buf, unsigned int len);
+void     pkt_free(struct pkt_rx * p, char * pkt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __PKT_H__ */
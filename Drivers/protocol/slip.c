@@ -0,0 +1,113 @@
+/* SLIP (RFC 1055) framing layer for the uart driver */
+
+#include "main.h"
+#include "slip.h"
+
+/*------------------------------------------------------------------------------
+  decode one received character (err: NZ if receive error)
+ *------------------------------------------------------------------------------*/
+void slip_rx(struct slip_rx * d, char c, char err)
+{
+  unsigned char b = (unsigned char)c;
+
+  if(b == SLIP_END)
+  {                                     /* end of the datagram */
+    if(d->skip || d->esc)
+      uart_frameq_abort(d->q);
+    else
+      uart_frameq_end(d->q);
+    d->esc = 0;
+    d->skip = 0;
+    return;
+  }
+
+  if(d->skip)
+    return;
+
+  if(err)
+  {
+    uart_frameq_abort(d->q);
+    d->skip = 1;
+    return;
+  }
+
+  if(d->esc)
+  {
+    d->esc = 0;
+    if(b == SLIP_ESC_END)
+      b = SLIP_END;
+    else if(b == SLIP_ESC_ESC)
+      b = SLIP_ESC;
+    else
+    {                                   /* invalid escape sequence */
+      uart_frameq_abort(d->q);
+      d->skip = 1;
+      return;
+    }
+  }
+  else if(b == SLIP_ESC)
+  {
+    d->esc = 1;
+    return;
+  }
+  uart_frameq_put(d->q, (char)b);
+}
+
+/*------------------------------------------------------------------------------
+  length of the encoded datagram (with the END characters)
+ *------------------------------------------------------------------------------*/
+unsigned int slip_enclen(const void * buf, unsigned int len)
+{
+  const unsigned char * p = (const unsigned char *)buf;
+  unsigned int r = len + 2;
+
+  while(len--)
+  {
+    if(*p == SLIP_END || *p == SLIP_ESC)
+      r++;
+    p++;
+  }
+  return r;
+}
+
+/*------------------------------------------------------------------------------
+  encode a datagram into the reserved TX buffer area (ts: slip_enclen long)
+ *------------------------------------------------------------------------------*/
+void slip_encode(struct uart_txspan * ts, const void * buf, unsigned int len)
+{
+  const unsigned char * p = (const unsigned char *)buf;
+
+  UART_TXSPAN_PUT(ts, (char)SLIP_END);
+  while(len--)
+  {
+    if(*p == SLIP_END)
+    {
+      UART_TXSPAN_PUT(ts, (char)SLIP_ESC);
+      UART_TXSPAN_PUT(ts, (char)SLIP_ESC_END);
+    }
+    else if(*p == SLIP_ESC)
+    {
+      UART_TXSPAN_PUT(ts, (char)SLIP_ESC);
+      UART_TXSPAN_PUT(ts, (char)SLIP_ESC_ESC);
+    }
+    else
+      UART_TXSPAN_PUT(ts, (char)*p);
+    p++;
+  }
+  UART_TXSPAN_PUT(ts, (char)SLIP_END);
+}
+
+/*------------------------------------------------------------------------------
+  encode a datagram directly into the TX buffer of the uart
+  return: 1 = ok, 0 = not sent
+ *------------------------------------------------------------------------------*/
+char slip_send(const struct uart_txport * port, const void * buf, unsigned int len)
+{
+  struct uart_txspan ts;
+
+  if(!uart_txport_reserve(port, slip_enclen(buf, len), &ts))
+    return 0;
+  slip_encode(&ts, buf, len);
+  port->commit();
+  return 1;
+}
@@ -0,0 +1,54 @@
+#ifndef __SLIP_H__
+#define __SLIP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* SLIP (RFC 1055) framing layer for the uart driver
+
+   Every datagram is closed with END (0xC0), END and ESC (0xDB) in the datagram are escaped
+   (ESC ESC_END, ESC ESC_ESC). The encoder also sends an END before the datagram (flushes the line noise).
+
+   - slip_rx: decode one received character into the frame queue (datagram queue)
+       note: it can be called from uartx_rxhook (in the interrupt) or from the main program (uartx_getchar)
+             e.g. char uart1_rxhook(char rxch, char err) { slip_rx(&slip1, rxch, err); return 1; }
+             only the complete datagrams are queued, read them with uart_frameq_get (see uart_proto.h)
+             datagrams with a receive error or an invalid escape sequence are dropped
+
+   - slip_enclen: length of the encoded datagram (with the END characters)
+
+   - slip_encode: encode a datagram into a reserved TX buffer area (ts must be slip_enclen long)
+
+   - slip_send: encode a datagram directly into the TX buffer of the uart
+       note: return = 1 -> the datagram is in the TX buffer, 0 -> not sent (larger than the TX buffer
+             or the TX buffer is full in interrupt)
+*/
+
+#include "uart_proto.h"
+
+#define  SLIP_END         0xC0
+#define  SLIP_ESC         0xDB
+#define  SLIP_ESC_END     0xDC
+#define  SLIP_ESC_ESC     0xDD
+
+/* decoder state */
+struct slip_rx {
+  struct uart_frameq * q;               /* frame queue of the decoded datagrams */
+  unsigned char esc;                    /* NZ: the previous character was ESC */
+  unsigned char skip;                   /* NZ: drop the characters to the next END */
+};
+
+#define  SLIP_RX_INIT(q)  { q, 0, 0 }
+
+void     slip_rx(struct slip_rx * d, char c, char err);
+unsigned int slip_enclen(const void * buf, unsigned int len);
+void     slip_encode(struct uart_txspan * ts, const void * buf, unsigned int len);
+char     slip_send(const struct uart_txport * port, const void * buf, unsigned int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __SLIP_H__ */
@@ -0,0 +1,89 @@
+#ifndef __UART_CRC_H__
+#define __UART_CRC_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* CRC calculation for the uart protocol layers
+
+   - CRC-16/CCITT (X.25, HDLC FCS-16, RFC 1662): polynomial 0x1021 (reflected: 0x8408), initial value 0xFFFF,
+     the result is inverted and sent low byte first
+       note: the CRC of a good frame with its FCS is UART_CRC16_CCITT_GOOD
+
+   - crc16_ccitt_byte: update the CRC with one character (table, it can be used in the interrupt)
+
+   - crc16_ccitt: CRC of a buffer (crc: the initial value or the result of the previous part)
+
+   - CRC-16/MODBUS: polynomial 0x8005 (reflected: 0xA001), initial value 0xFFFF, sent low byte first
+       note: the CRC of a good frame with its CRC is 0
+
+   - crc16_modbus_byte, crc16_modbus: like the CRC-16/CCITT functions
+
+   - CRC-32 (ISO-HDLC, zip, ethernet): polynomial 0x04C11DB7 (reflected: 0xEDB88320), initial value 0xFFFFFFFF,
+     the result is inverted and sent low byte first
+       note: software: slicing-by-8 (8 x 1 kbyte table) or byte by byte (UART_CRC32_SLICING = 1, 1 kbyte table)
+
+   - crc32: CRC-32 of a buffer (crc: the initial value or the result of the previous part)
+       note: a received frame in 2 parts (frame queue, DMA ring): crc = crc32(crc32(UART_CRC32_INIT, p1, n1), p2, n2)
+
+   - UART_CRC_HW: 1 -> crc16_ccitt, crc16_modbus and crc32 use the CRC unit of the microcontroller
+       note: programmable CRC unit (polynomial and bit reversal, e.g. f072, f3, f7, h7): all three CRCs,
+             fixed CRC-32 unit (f1, f2, f4): crc32 only, the aligned words bit reversed (RBIT) by the unit,
+             the characters before and after them with the table (crc16_... use the software)
+             in interrupt the software calculation is used (the CRC unit is not shared with the interrupts)
+             RTOS: the CRC unit is used by one task at a time, the other tasks use the software meanwhile
+*/
+
+/* use the CRC unit of the microcontroller (0 = software only) */
+#ifndef UART_CRC_HW
+#define  UART_CRC_HW             0
+#endif
+
+/* CRC-32 software table: 8 = slicing-by-8 (8 kbyte), 1 = byte by byte (1 kbyte) */
+#ifndef UART_CRC32_SLICING
+#define  UART_CRC32_SLICING      8
+#endif
+
+#include <stdint.h>
+
+#define  UART_CRC16_CCITT_INIT   0xFFFF
+#define  UART_CRC16_CCITT_GOOD   0xF0B8
+
+extern const unsigned short crc16_ccitt_table[256];
+
+static inline unsigned short crc16_ccitt_byte(unsigned short crc, char c)
+{
+  return (crc >> 8) ^ crc16_ccitt_table[(crc ^ (unsigned char)c) & 0xFF];
+}
+
+unsigned short crc16_ccitt(unsigned short crc, const void * buf, unsigned int len);
+
+#define  UART_CRC16_MODBUS_INIT  0xFFFF
+
+extern const unsigned short crc16_modbus_table[256];
+
+static inline unsigned short crc16_modbus_byte(unsigned short crc, char c)
+{
+  return (crc >> 8) ^ crc16_modbus_table[(crc ^ (unsigned char)c) & 0xFF];
+}
+
+unsigned short crc16_modbus(unsigned short crc, const void * buf, unsigned int len);
+
+#define  UART_CRC32_INIT         0xFFFFFFFF
+
+extern const uint32_t crc32_table[UART_CRC32_SLICING][256];
+
+static inline uint32_t crc32_byte(uint32_t crc, char c)
+{
+  return (crc >> 8) ^ crc32_table[0][(crc ^ (unsigned char)c) & 0xFF];
+}
+
+uint32_t crc32(uint32_t crc, const void * buf, unsigned int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __UART_CRC_H__ */
@@ -0,0 +1,189 @@
+/* Hex and base64 encoders writing directly into the TX buffer */
+
+#include <stdint.h>
+#include <string.h>
+#include "main.h"
+#include "uart_enc.h"
+
+/*------------------------------------------------------------------------------
+  write n (1..4) characters from a word (little endian: the first character is the lowest byte)
+ *------------------------------------------------------------------------------*/
+static inline void enc_put(struct uart_txspan * ts, uint32_t w, unsigned int n)
+{
+  if(n == 4 && ts->n1 >= 4)
+  {
+    memcpy(ts->p1, &w, 4);
+    ts->p1 += 4;
+    ts->n1 -= 4;
+    return;
+  }
+  while(n--)
+  {
+    UART_TXSPAN_PUT(ts, (char)w);
+    w >>= 8;
+  }
+}
+
+/*------------------------------------------------------------------------------
+  4 nibbles (one in every byte) to 4 hex characters
+ *------------------------------------------------------------------------------*/
+static inline uint32_t enc_hex4(uint32_t n)
+{
+  #if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP == 1
+  (void)__UADD8(n, 0xF6F6F6F6);         /* GE bit = 1 if the nibble >= 10 */
+  return __UADD8(n, __SEL(0x37373737, 0x30303030)); /* + 'A' - 10 or + '0' */
+  #else
+  uint32_t ge10 = ((n + 0x76767676) & 0x80808080) >> 7; /* 1 in the bytes with nibble >= 10 */
+  return n + 0x30303030 + ge10 * 7;
+  #endif
+}
+
+/*------------------------------------------------------------------------------
+  2 bytes (lower 16 bits of w) to 4 hex characters
+ *------------------------------------------------------------------------------*/
+static inline uint32_t enc_hex2(uint32_t w)
+{
+  uint32_t hi = (w >> 4) & 0x0F0F;
+  uint32_t lo = w & 0x0F0F;
+  hi = (hi | (hi << 8)) & 0x000F000F;   /* hi0 -> byte 0, hi1 -> byte 2 */
+  lo = (lo | (lo << 8)) & 0x000F000F;
+  return enc_hex4(hi | (lo << 8));
+}
+
+/*------------------------------------------------------------------------------
+  hex encoding (2 * len characters)
+ *------------------------------------------------------------------------------*/
+void uart_hexenc(struct uart_txspan * ts, const void * buf, unsigned int len)
+{
+  const unsigned char * p = (const unsigned char *)buf;
+  uint32_t w;
+
+  for(; len >= 4; len -= 4, p += 4)
+  {
+    w = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    enc_put(ts, enc_hex2(w), 4);
+    enc_put(ts, enc_hex2(w >> 16), 4);
+  }
+  if(len)
+  {
+    w = p[0] | ((len > 1) ? p[1] << 8 : 0) | ((len > 2) ? p[2] << 16 : 0);
+    enc_put(ts, enc_hex2(w), (len >= 2) ? 4 : 2);
+    if(len == 3)
+      enc_put(ts, enc_hex2(w >> 16), 2);
+  }
+}
+
+/*------------------------------------------------------------------------------
+  base64 encoding (uart_base64len(len) characters)
+ *------------------------------------------------------------------------------*/
+void uart_base64enc(struct uart_txspan * ts, const void * buf, unsigned int len)
+{
+  static const char b64[64] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  const unsigned char * p = (const unsigned char *)buf;
+  uint32_t v, w;
+
+  for(; len >= 3; len -= 3, p += 3)
+  {
+    v = (p[0] << 16) | (p[1] << 8) | p[2];
+    w = b64[v >> 18] | (b64[(v >> 12) & 63] << 8) | (b64[(v >> 6) & 63] << 16) | ((uint32_t)b64[v & 63] << 24);
+    enc_put(ts, w, 4);
+  }
+  if(len)
+  {
+    v = (p[0] << 16) | ((len == 2) ? p[1] << 8 : 0);
+    w = b64[v >> 18] | (b64[(v >> 12) & 63] << 8) | ((len == 2) ? b64[(v >> 6) & 63] << 16 : '=' << 16) | ((uint32_t)'=' << 24);
+    enc_put(ts, w, 4);
+  }
+}
+
+/*------------------------------------------------------------------------------
+  hex dump to a TX port (16 bytes / line)
+ *------------------------------------------------------------------------------*/
+char uart_hexdump(const struct uart_txport * port, const void * buf, unsigned int len)
+{
+  const unsigned char * p = (const unsigned char *)buf;
+  struct uart_txspan ts;
+  unsigned int n, ofs = 0;
+  unsigned char o[4];
+
+  while(len)
+  {
+    n = (len < 16) ? len : 16;
+    if(!uart_txport_reserve(port, 8 + 2 + 2 * n + 2, &ts))
+      return 0;
+    o[0] = ofs >> 24;
+    o[1] = ofs >> 16;
+    o[2] = ofs >> 8;
+    o[3] = ofs;
+    uart_hexenc(&ts, o, 4);
+    enc_put(&ts, ':' | (' ' << 8), 2);
+    uart_hexenc(&ts, p, n);
+    enc_put(&ts, '\r' | ('\n' << 8), 2);
+    port->commit();
+    p += n;
+    ofs += n;
+    len -= n;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  base64 to a TX port (in parts of max 64 characters)
+ *------------------------------------------------------------------------------*/
+char uart_base64(const struct uart_txport * port, const void * buf, unsigned int len)
+{
+  const unsigned char * p = (const unsigned char *)buf;
+  struct uart_txspan ts;
+  unsigned int n;
+
+  while(len)
+  {
+    n = (len < 48) ? len : 48;
+    if(!uart_txport_reserve(port, uart_base64len(n), &ts))
+      return 0;
+    uart_base64enc(&ts, p, n);
+    port->commit();
+    p += n;
+    len -= n;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  uartx_hexdump, uartx_base64 (only the used uarts)
+ *------------------------------------------------------------------------------*/
+#define  UART_ENC_FUNC(x)                                                     \
+static const struct uart_txport uart ## x ## _encport = UART_TXPORT(x);       \
+char uart ## x ## _hexdump(const void * buf, unsigned int len)                \
+{                                                                             \
+  return uart_hexdump(&uart ## x ## _encport, buf, len);                      \
+}                                                                             \
+char uart ## x ## _base64(const void * buf, unsigned int len)                 \
+{                                                                             \
+  return uart_base64(&uart ## x ## _encport, buf, len);                       \
+}
+
+#if defined(UART1_BAUDRATE) && UART1_BAUDRATE > 0
+UART_ENC_FUNC(1)
+#endif
+#if defined(UART2_BAUDRATE) && UART2_BAUDRATE > 0
+UART_ENC_FUNC(2)
+#endif
+#if defined(UART3_BAUDRATE) && UART3_BAUDRATE > 0
+UART_ENC_FUNC(3)
+#endif
+#if defined(UART4_BAUDRATE) && UART4_BAUDRATE > 0
+UART_ENC_FUNC(4)
+#endif
+#if defined(UART5_BAUDRATE) && UART5_BAUDRATE > 0
+UART_ENC_FUNC(5)
+#endif
+#if defined(UART6_BAUDRATE) && UART6_BAUDRATE > 0
+UART_ENC_FUNC(6)
+#endif
+#if defined(UART7_BAUDRATE) && UART7_BAUDRATE > 0
+UART_ENC_FUNC(7)
+#endif
+#if defined(UART8_BAUDRATE) && UART8_BAUDRATE > 0
+UART_ENC_FUNC(8)
+#endif
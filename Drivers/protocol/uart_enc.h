@@ -0,0 +1,62 @@
+#ifndef __UART_ENC_H__
+#define __UART_ENC_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* Hex and base64 encoders writing directly into the TX buffer
+
+   The input is processed 32 bits at a time, the characters are written into the reserved
+   area of the TX buffer (uartx_txreserve, uartx_txcommit).
+   hex: the nibbles of 4 bytes are converted to ASCII in 2 words without table,
+        Cortex-M4/M7 (DSP extension): UADD8 + SEL, other: portable SWAR (M0, M3, host)
+   base64: 3 bytes -> 4 characters (RFC 4648, with '=' padding, without line breaks)
+
+   - uartx_hexdump: hex dump to the uart x (x = 1..8, if this uart is used)
+       note: 16 bytes / line: "oooooooo: 00112233445566778899AABBCCDDEEFF\r\n" (oooooooo: offset)
+             every line is written into the TX buffer separately (not block the other messages)
+
+   - uartx_base64: base64 to the uart x (x = 1..8, if this uart is used)
+       note: written in parts of max 64 characters
+
+   - uart_hexdump, uart_base64: like the uartx_ functions to a TX port (see uart_proto.h)
+       note: return = 1 -> done, 0 -> not (completely) sent (the TX buffer is full in interrupt)
+
+   - uart_hexenc, uart_base64enc: encode into a reserved TX buffer area (ts must be 2 * len and
+     uart_base64len(len) long)
+*/
+
+#include "uart_proto.h"
+
+#define  uart_base64len(len)  ((((len) + 2) / 3) * 4)
+
+void     uart_hexenc(struct uart_txspan * ts, const void * buf, unsigned int len);
+void     uart_base64enc(struct uart_txspan * ts, const void * buf, unsigned int len);
+char     uart_hexdump(const struct uart_txport * port, const void * buf, unsigned int len);
+char     uart_base64(const struct uart_txport * port, const void * buf, unsigned int len);
+
+char     uart1_hexdump(const void * buf, unsigned int len);
+char     uart2_hexdump(const void * buf, unsigned int len);
+char     uart3_hexdump(const void * buf, unsigned int len);
+char     uart4_hexdump(const void * buf, unsigned int len);
+char     uart5_hexdump(const void * buf, unsigned int len);
+char     uart6_hexdump(const void * buf, unsigned int len);
+char     uart7_hexdump(const void * buf, unsigned int len);
+char     uart8_hexdump(const void * buf, unsigned int len);
+
+char     uart1_base64(const void * buf, unsigned int len);
+char     uart2_base64(const void * buf, unsigned int len);
+char     uart3_base64(const void * buf, unsigned int len);
+char     uart4_base64(const void * buf, unsigned int len);
+char     uart5_base64(const void * buf, unsigned int len);
+char     uart6_base64(const void * buf, unsigned int len);
+char     uart7_base64(const void * buf, unsigned int len);
+char     uart8_base64(const void * buf, unsigned int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __UART_ENC_H__ */
@@ -0,0 +1,368 @@
+/* Lightweight printf for the uart driver */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "main.h"
+#include "uart_fmt.h"
+
+/* output of the formatter */
+struct fmt_out {
+  struct uart_txspan * ts;              /* TX buffer area (0 = not TX buffer) */
+  char * buf;                           /* buffer (0 = not buffer) */
+  unsigned int size;                    /* buffer size */
+  unsigned int n;                       /* number of the formatted characters */
+};
+
+#define  FMT_LEFT   0x01
+#define  FMT_ZERO   0x02
+#define  FMT_PLUS   0x04
+#define  FMT_SPACE  0x08
+
+/*------------------------------------------------------------------------------
+  one character to the output (if ts = 0 and buf = 0: only counting)
+ *------------------------------------------------------------------------------*/
+static inline void fmt_putc(struct fmt_out * o, char c)
+{
+  if(o->ts)
+  {                                     /* not over the reserved area (an argument changed after the counting) */
+    if(o->ts->n1 || o->ts->n2)
+      UART_TXSPAN_PUT(o->ts, c)
+  }
+  else if(o->buf && o->n + 1 < o->size)
+    o->buf[o->n] = c;
+  o->n++;
+}
+
+static void fmt_pad(struct fmt_out * o, char c, int n)
+{
+  while(n-- > 0)
+    fmt_putc(o, c);
+}
+
+/*------------------------------------------------------------------------------
+  sign / prefix, digits and the padding
+  - pre: sign or prefix (0 = none), s: digits, n: number of digits
+ *------------------------------------------------------------------------------*/
+static void fmt_field(struct fmt_out * o, const char * pre, const char * s, int n, int width, int zeros, unsigned char flags)
+{
+  int np = 0;
+
+  while(pre && pre[np])
+    np++;
+  width -= np + zeros + n;
+  if(!(flags & (FMT_LEFT | FMT_ZERO)))
+    fmt_pad(o, ' ', width);
+  while(np--)
+    fmt_putc(o, *pre++);
+  if(flags & FMT_ZERO && !(flags & FMT_LEFT))
+    fmt_pad(o, '0', width);
+  fmt_pad(o, '0', zeros);
+  while(n--)
+    fmt_putc(o, *s++);
+  if(flags & FMT_LEFT)
+    fmt_pad(o, ' ', width);
+}
+
+/*------------------------------------------------------------------------------
+  unsigned integer to digits (backward from the end of buf)
+  return: pointer to the first digit
+ *------------------------------------------------------------------------------*/
+static char * fmt_utoa(char * end, unsigned long long v, unsigned int base, char upper)
+{
+  const char * d = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  unsigned long v32;
+
+  while(v > 0xFFFFFFFFUL)
+  {                                     /* 64 bit division only if it is necessary */
+    *--end = d[v % base];
+    v /= base;
+  }
+  v32 = (unsigned long)v;
+  do
+  {
+    *--end = d[v32 % base];
+    v32 /= base;
+  } while(v32);
+  return end;
+}
+
+/*------------------------------------------------------------------------------
+  integer conversions
+ *------------------------------------------------------------------------------*/
+static void fmt_int(struct fmt_out * o, unsigned long long v, char neg, unsigned int base, char upper, int width, int prec, unsigned char flags)
+{
+  char b[24], * s;
+  const char * pre = neg ? "-" : (flags & FMT_PLUS) ? "+" : (flags & FMT_SPACE) ? " " : 0;
+  int n;
+
+  if(!v && !prec)
+    s = &b[sizeof(b)];                  /* precision 0 and value 0: no digits */
+  else
+    s = fmt_utoa(&b[sizeof(b)], v, base, upper);
+  n = &b[sizeof(b)] - s;
+  if(prec >= 0)
+    flags &= ~FMT_ZERO;
+  fmt_field(o, pre, s, n, width, (prec > n) ? prec - n : 0, flags);
+}
+
+/*------------------------------------------------------------------------------
+  fixed-point float
+ *------------------------------------------------------------------------------*/
+static void fmt_float(struct fmt_out * o, double v, int width, int prec, unsigned char flags)
+{
+  static const unsigned long p10[10] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+  char b[32], * s, * e = &b[sizeof(b)];
+  const char * pre;
+  unsigned long long ip;
+  unsigned long fp;
+  int i;
+
+  if(prec < 0)
+    prec = 6;
+  if(prec > 9)
+    prec = 9;
+  pre = (v < 0) ? "-" : (flags & FMT_PLUS) ? "+" : (flags & FMT_SPACE) ? " " : 0;
+  if(v < 0)
+    v = -v;
+
+  if(v != v || v >= 18446744073709551616.0)
+  {                                     /* nan, inf or too large */
+    flags &= ~FMT_ZERO;
+    fmt_field(o, pre, (v != v) ? "nan" : "inf", 3, width, 0, flags);
+    return;
+  }
+
+  ip = (unsigned long long)v;           /* v - ip is exact: the fraction is rounded alone */
+  fp = (unsigned long)((v - (double)ip) * p10[prec] + 0.5);
+  if(fp >= p10[prec])
+  {                                     /* rounded up to the next integer */
+    fp -= p10[prec];
+    ip++;
+  }
+
+  s = e;
+  if(prec)
+  {
+    for(i = 0; i < prec; i++)
+    {
+      *--s = '0' + fp % 10;
+      fp /= 10;
+    }
+    *--s = '.';
+  }
+  s = fmt_utoa(s, ip, 10, 0);
+  fmt_field(o, pre, s, e - s, width, 0, flags);
+}
+
+/*------------------------------------------------------------------------------
+  the formatter
+ *------------------------------------------------------------------------------*/
+static void fmt_run(struct fmt_out * o, const char * fmt, va_list ap)
+{
+  unsigned char flags;
+  int width, prec, n, lng;
+  unsigned long long u;
+  long long d;
+  const char * s;
+  char c;
+
+  while((c = *fmt++))
+  {
+    if(c != '%')
+    {
+      fmt_putc(o, c);
+      continue;
+    }
+
+    flags = 0;
+    for(;; fmt++)
+    {
+      if(*fmt == '-') flags |= FMT_LEFT;
+      else if(*fmt == '0') flags |= FMT_ZERO;
+      else if(*fmt == '+') flags |= FMT_PLUS;
+      else if(*fmt == ' ') flags |= FMT_SPACE;
+      else if(*fmt != '#') break;
+    }
+
+    width = 0;
+    if(*fmt == '*')
+    {
+      fmt++;
+      width = va_arg(ap, int);
+      if(width < 0)
+      {
+        flags |= FMT_LEFT;
+        width = -width;
+      }
+    }
+    else
+      while(*fmt >= '0' && *fmt <= '9')
+        width = width * 10 + (*fmt++ - '0');
+
+    prec = -1;
+    if(*fmt == '.')
+    {
+      fmt++;
+      prec = 0;
+      if(*fmt == '*')
+      {
+        fmt++;
+        prec = va_arg(ap, int);
+      }
+      else
+        while(*fmt >= '0' && *fmt <= '9')
+          prec = prec * 10 + (*fmt++ - '0');
+    }
+
+    lng = 0;                            /* 1 = long, 2 = long long, -1 = short, -2 = char */
+    for(;; fmt++)
+    {
+      if(*fmt == 'l') lng++;
+      else if(*fmt == 'h') lng--;
+      else if(*fmt == 'z') lng = (sizeof(size_t) > sizeof(int)) ? 1 : 0;
+      else break;
+    }
+
+    switch(c = *fmt++)
+    {
+      case 'd': case 'i':
+        d = (lng >= 2) ? va_arg(ap, long long) : (lng == 1) ? va_arg(ap, long) : va_arg(ap, int);
+        if(lng < 0)
+          d = (lng == -1) ? (short)d : (signed char)d;
+        fmt_int(o, (d < 0) ? -(unsigned long long)d : (unsigned long long)d, d < 0, 10, 0, width, prec, flags);
+        break;
+      case 'u': case 'x': case 'X': case 'o':
+        u = (lng >= 2) ? va_arg(ap, unsigned long long) : (lng == 1) ? va_arg(ap, unsigned long) : va_arg(ap, unsigned int);
+        if(lng < 0)
+          u = (lng == -1) ? (unsigned short)u : (unsigned char)u;
+        fmt_int(o, u, 0, (c == 'u') ? 10 : (c == 'o') ? 8 : 16, c == 'X', width, prec, flags & ~(FMT_PLUS | FMT_SPACE));
+        break;
+      case 'p':
+        fmt_int(o, (unsigned long long)(uintptr_t)va_arg(ap, void *), 0, 16, 0, width, 2 * sizeof(void *), 0);
+        break;
+      case 'f': case 'F':
+        fmt_float(o, va_arg(ap, double), width, prec, flags);
+        break;
+      case 'c':
+        c = (char)va_arg(ap, int);
+        fmt_field(o, 0, &c, 1, width, 0, flags & ~FMT_ZERO);
+        break;
+      case 's':
+        s = va_arg(ap, const char *);
+        if(!s)
+          s = "(null)";
+        for(n = 0; s[n] && (prec < 0 || n < prec); n++);
+        fmt_field(o, 0, s, n, width, 0, flags & ~FMT_ZERO);
+        break;
+      case '%':
+        fmt_putc(o, '%');
+        break;
+      case 0:
+        return;
+      default:                          /* unknown conversion: printed */
+        fmt_putc(o, '%');
+        fmt_putc(o, c);
+        break;
+    }
+  }
+}
+
+/*------------------------------------------------------------------------------
+  printf to a TX port
+ *------------------------------------------------------------------------------*/
+int uart_vprintf(const struct uart_txport * port, const char * fmt, va_list ap)
+{
+  struct fmt_out o = { 0, 0, 0, 0 };
+  struct uart_txspan ts;
+  unsigned int n;
+  va_list ap2;
+
+  va_copy(ap2, ap);
+  fmt_run(&o, fmt, ap2);                /* length */
+  va_end(ap2);
+  if(!o.n)
+    return 0;
+  if(!uart_txport_reserve(port, o.n, &ts))
+    return -1;
+  n = o.n;
+  o.ts = &ts;
+  o.n = 0;
+  fmt_run(&o, fmt, ap);
+  while(ts.n1 || ts.n2)                 /* shorter than counted: padded to the reserved length */
+    UART_TXSPAN_PUT(&ts, ' ')
+  port->commit();
+  return n;
+}
+
+int uart_printf(const struct uart_txport * port, const char * fmt, ...)
+{
+  va_list ap;
+  int r;
+  va_start(ap, fmt);
+  r = uart_vprintf(port, fmt, ap);
+  va_end(ap);
+  return r;
+}
+
+/*------------------------------------------------------------------------------
+  printf to a buffer
+ *------------------------------------------------------------------------------*/
+int uart_vsnprintf(char * buf, unsigned int size, const char * fmt, va_list ap)
+{
+  struct fmt_out o = { 0, buf, size, 0 };
+
+  fmt_run(&o, fmt, ap);
+  if(size)
+    buf[(o.n < size) ? o.n : size - 1] = 0;
+  return o.n;
+}
+
+int uart_snprintf(char * buf, unsigned int size, const char * fmt, ...)
+{
+  va_list ap;
+  int r;
+  va_start(ap, fmt);
+  r = uart_vsnprintf(buf, size, fmt, ap);
+  va_end(ap);
+  return r;
+}
+
+/*------------------------------------------------------------------------------
+  uartx_printf (only the used uarts)
+ *------------------------------------------------------------------------------*/
+#define  UART_FMT_PRINTF(x)                                                   \
+int uart ## x ## _printf(const char * fmt, ...)                               \
+{                                                                             \
+  static const struct uart_txport port = UART_TXPORT(x);                      \
+  va_list ap;                                                                 \
+  int r;                                                                      \
+  va_start(ap, fmt);                                                          \
+  r = uart_vprintf(&port, fmt, ap);                                           \
+  va_end(ap);                                                                 \
+  return r;                                                                   \
+}
+
+#if defined(UART1_BAUDRATE) && UART1_BAUDRATE > 0
+UART_FMT_PRINTF(1)
+#endif
+#if defined(UART2_BAUDRATE) && UART2_BAUDRATE > 0
+UART_FMT_PRINTF(2)
+#endif
+#if defined(UART3_BAUDRATE) && UART3_BAUDRATE > 0
+UART_FMT_PRINTF(3)
+#endif
+#if defined(UART4_BAUDRATE) && UART4_BAUDRATE > 0
+UART_FMT_PRINTF(4)
+#endif
+#if defined(UART5_BAUDRATE) && UART5_BAUDRATE > 0
+UART_FMT_PRINTF(5)
+#endif
+#if defined(UART6_BAUDRATE) && UART6_BAUDRATE > 0
+UART_FMT_PRINTF(6)
+#endif
+#if defined(UART7_BAUDRATE) && UART7_BAUDRATE > 0
+UART_FMT_PRINTF(7)
+#endif
+#if defined(UART8_BAUDRATE) && UART8_BAUDRATE > 0
+UART_FMT_PRINTF(8)
+#endif
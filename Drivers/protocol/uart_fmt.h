@@ -0,0 +1,56 @@
+#ifndef __UART_FMT_H__
+#define __UART_FMT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* Lightweight printf for the uart driver (without newlib printf, malloc and large stack)
+
+   The message is formatted twice: first only the length is counted, then the characters
+   are written directly into the reserved area of the TX buffer (uartx_txreserve, uartx_txcommit),
+   so the message is not mixed with the messages of the other tasks / interrupts.
+   The functions are reentrant (no static variables).
+
+   formats: %[flags][width][.precision][length]conversion
+     flags: '-' (left justify), '0' (zero padding), '+' (sign), ' ' (space instead of '+')
+     width, precision: number or '*'
+     length: h, hh, l, ll, z (ll: 64 bit integer)
+     conversion: d, i, u, x, X, o, c, s, p, %,
+                 f: fixed-point float (precision 0..9, default 6, |value| < 2^64, rounding half up)
+
+   - uartx_printf: printf to the uart x (x = 1..8, if this uart is used)
+       note: return = number of characters, -1 -> not sent (longer than the TX buffer
+             or the TX buffer is full in interrupt)
+
+   - uart_printf, uart_vprintf: printf to a TX port (see uart_proto.h)
+       note: if a %s string is changed by another task / interrupt between the two passes,
+             the message is truncated or padded with spaces to the counted length
+
+   - uart_snprintf, uart_vsnprintf: printf to a buffer (always zero terminated if size > 0)
+       note: return = length of the whole formatted text (can be more than size - 1)
+*/
+
+#include <stdarg.h>
+#include "uart_proto.h"
+
+int      uart_vprintf(const struct uart_txport * port, const char * fmt, va_list ap);
+int      uart_printf(const struct uart_txport * port, const char * fmt, ...) __attribute__((format(printf, 2, 3)));
+int      uart_vsnprintf(char * buf, unsigned int size, const char * fmt, va_list ap);
+int      uart_snprintf(char * buf, unsigned int size, const char * fmt, ...) __attribute__((format(printf, 3, 4)));
+
+int      uart1_printf(const char * fmt, ...) __attribute__((format(printf, 1, 2)));
+int      uart2_printf(const char * fmt, ...) __attribute__((format(printf, 1, 2)));
+int      uart3_printf(const char * fmt, ...) __attribute__((format(printf, 1, 2)));
+int      uart4_printf(const char * fmt, ...) __attribute__((format(printf, 1, 2)));
+int      uart5_printf(const char * fmt, ...) __attribute__((format(printf, 1, 2)));
+int      uart6_printf(const char * fmt, ...) __attribute__((format(printf, 1, 2)));
+int      uart7_printf(const char * fmt, ...) __attribute__((format(printf, 1, 2)));
+int      uart8_printf(const char * fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __UART_FMT_H__ */
@@ -0,0 +1,100 @@
+/* Common parts of the uart protocol layers (frame queue, TX port) */
+
+#include <string.h>
+#include "main.h"
+#include "uart_proto.h"
+
+/*------------------------------------------------------------------------------
+  close the open frame and publish it to the reader (writer side)
+  return: 1 = the frame is in the queue, 0 = lost (overflow) or empty frame
+ *------------------------------------------------------------------------------*/
+char uart_frameq_end(struct uart_frameq * q)
+{
+  unsigned int len = q->wr - q->in;
+
+  if(q->ovf || q->fin - q->fout >= q->fsize)
+  {
+    q->lost++;
+    uart_frameq_abort(q);
+    return 0;
+  }
+  if(!len)
+    return 0;
+
+  q->flen[q->fin & (q->fsize - 1)] = len;
+  q->in = q->wr;
+  __DMB();                              /* the frame is in the buffer before publishing */
+  q->fin++;
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  get the oldest frame (reader side)
+  return: 1 = the frame is in f (release it with uart_frameq_free), 0 = no frame
+ *------------------------------------------------------------------------------*/
+char uart_frameq_get(struct uart_frameq * q, struct uart_frame * f)
+{
+  unsigned int pos, len;
+
+  if(q->fin == q->fout)
+    return 0;                           /* empty */
+
+  __DMB();
+  len = q->flen[q->fout & (q->fsize - 1)];
+  pos = q->out & (q->size - 1);
+  f->p1 = &q->buf[pos];
+  f->p2 = &q->buf[0];
+  if(pos + len <= q->size)
+  {
+    f->n1 = len;
+    f->n2 = 0;
+  }
+  else
+  {
+    f->n1 = q->size - pos;
+    f->n2 = len - f->n1;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  release the oldest frame (reader side)
+ *------------------------------------------------------------------------------*/
+void uart_frameq_free(struct uart_frameq * q)
+{
+  if(q->fin == q->fout)
+    return;
+  q->out += q->flen[q->fout & (q->fsize - 1)];
+  q->fout++;
+}
+
+/*------------------------------------------------------------------------------
+  copy the frame to dst (max: size of dst)
+  return: number of copied characters
+ *------------------------------------------------------------------------------*/
+unsigned int uart_frame_copy(const struct uart_frame * f, void * dst, unsigned int max)
+{
+  unsigned int n1 = (f->n1 < max) ? f->n1 : max;
+  unsigned int n2 = (f->n2 < max - n1) ? f->n2 : max - n1;
+  memcpy(dst, f->p1, n1);
+  memcpy((char *)dst + n1, f->p2, n2);
+  return n1 + n2;
+}
+
+/*------------------------------------------------------------------------------
+  reserve space in the TX buffer of the port
+  return: 1 = ok (fill it and call port->commit), 0 = the frame is larger than the TX buffer
+  note: if the TX buffer is full, in the main program it will wait until there is free space in it,
+        in interrupt it returns 0 without waiting
+ *------------------------------------------------------------------------------*/
+char uart_txport_reserve(const struct uart_txport * port, unsigned int len, struct uart_txspan * ts)
+{
+  if(len > port->size)
+    return 0;
+  while(!port->reserve(len, ts))
+  {
+    if(__get_IPSR())
+      return 0;
+  }
+  return 1;
+}
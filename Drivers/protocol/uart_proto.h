@@ -0,0 +1,117 @@
+#ifndef __UART_PROTO_H__
+#define __UART_PROTO_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* Common parts of the uart protocol layers (cobs, ...)
+
+   The protocol layers are independent of the stm32 family, they use the uart.h of the family.
+   Receive: the decoder is fed from uartx_rxhook (in the interrupt, UARTx_RXHOOK = 1)
+            or from the main program with uartx_getchar.
+            The decoded frames are written directly into a frame queue (no extra buffer pass).
+   Transmit: the encoder writes directly into the TX buffer of the uart (uartx_txreserve, uartx_txcommit),
+             so the frames are not mixed with the other messages.
+
+   - struct uart_frameq: frame queue (one writer: the decoder, one reader: the application)
+       note: buffer size and the number of frames should be (2 ^ n) !
+             UART_FRAMEQ_INIT(buf, flen): initializer with a char and an unsigned int array
+
+   - uart_frameq_get: get the oldest frame
+       note: if return = 0 -> no frame received (not block the program from running)
+             if return = 1 -> the frame is in the frame queue (in 2 parts if it wraps the end of the buffer),
+                              after processing it must be released with uart_frameq_free
+
+   - uart_frame_at, uart_frame_copy: read one character or copy the frame
+
+   - struct uart_txport: the TX buffer of one uart
+       note: UART_TXPORT(x): initializer for the uart x (e.g. UART_TXPORT(1))
+*/
+
+#include "uart.h"
+
+//----------------------------------------------------------------------------
+/* frame queue */
+struct uart_frameq {
+  char * buf;                           /* Buffer */
+  unsigned int size;                    /* Buffer size (2 ^ n) */
+  unsigned int * flen;                  /* Frame lengths */
+  unsigned int fsize;                   /* Number of frame lengths (2 ^ n) */
+  volatile unsigned int in;             /* Next In Index (end of the last complete frame) */
+  volatile unsigned int out;            /* Next Out Index */
+  unsigned int wr;                      /* Write Index of the open frame */
+  volatile unsigned int fin;            /* Next In Frame */
+  volatile unsigned int fout;           /* Next Out Frame */
+  unsigned int ovf;                     /* NZ if the open frame does not fit in the buffer */
+  volatile unsigned int lost;           /* Number of lost frames (overflow) */
+};
+
+#define  UART_FRAMEQ_INIT(buf, flen)  { buf, sizeof(buf), flen, sizeof(flen) / sizeof(flen[0]), 0, 0, 0, 0, 0, 0, 0 }
+
+/* a received frame in the frame queue (2 parts if it wraps the end of the buffer) */
+struct uart_frame {
+  char * p1;                            /* first part */
+  unsigned int n1;                      /* length of the first part */
+  char * p2;                            /* second part (from the beginning of the buffer) */
+  unsigned int n2;                      /* length of the second part */
+};
+
+/* TX buffer of one uart */
+struct uart_txport {
+  char (*reserve)(unsigned int len, struct uart_txspan * ts);
+  void (*commit)(void);
+  unsigned int size;                    /* TX buffer size */
+};
+
+#define  UART_TXPORT(x)  { uart ## x ## _txreserve, uart ## x ## _txcommit, TXBUF ## x ## _SIZE }
+
+/* add a character to the open frame (writer side) */
+static inline void uart_frameq_put(struct uart_frameq * q, char c)
+{
+  if(q->wr - q->out < q->size)
+  {
+    q->buf[q->wr & (q->size - 1)] = c;
+    q->wr++;
+  }
+  else
+    q->ovf = 1;
+}
+
+/* drop the open frame (writer side) */
+static inline void uart_frameq_abort(struct uart_frameq * q)
+{
+  q->wr = q->in;
+  q->ovf = 0;
+}
+
+/* remove the last n characters of the open frame, e.g. the checksum (writer side) */
+static inline void uart_frameq_trim(struct uart_frameq * q, unsigned int n)
+{
+  q->wr = (q->wr - q->in > n) ? q->wr - n : q->in;
+}
+
+/* length of the open frame (writer side) */
+static inline unsigned int uart_frameq_len(struct uart_frameq * q)
+{
+  return q->wr - q->in;
+}
+
+/* i-th character of the frame */
+static inline char uart_frame_at(const struct uart_frame * f, unsigned int i)
+{
+  return (i < f->n1) ? f->p1[i] : f->p2[i - f->n1];
+}
+
+char     uart_frameq_end(struct uart_frameq * q);
+char     uart_frameq_get(struct uart_frameq * q, struct uart_frame * f);
+void     uart_frameq_free(struct uart_frameq * q);
+unsigned int uart_frame_copy(const struct uart_frame * f, void * dst, unsigned int max);
+char     uart_txport_reserve(const struct uart_txport * port, unsigned int len, struct uart_txspan * ts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __UART_PROTO_H__ */
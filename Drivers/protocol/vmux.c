@@ -0,0 +1,146 @@
+/* Virtual channel multiplexer over one uart */
+
+#include "main.h"
+#include "vmux.h"
+
+/*------------------------------------------------------------------------------
+  write characters into the TX ring of the channel
+ *------------------------------------------------------------------------------*/
+unsigned int vmux_write(struct vmux * m, unsigned int ch, const void * buf, unsigned int len)
+{
+  struct vmux_chan * c = &m->ch[ch];
+  const char * p = (const char *)buf;
+  unsigned int n = 0;
+
+  while(n < len && c->txin - c->txout < c->txsize)
+  {
+    c->txbuf[c->txin & (c->txsize - 1)] = p[n++];
+    c->txin++;
+  }
+  return n;
+}
+
+/*------------------------------------------------------------------------------
+  read characters from the RX ring of the channel
+ *------------------------------------------------------------------------------*/
+unsigned int vmux_read(struct vmux * m, unsigned int ch, void * buf, unsigned int max)
+{
+  struct vmux_chan * c = &m->ch[ch];
+  char * p = (char *)buf;
+  unsigned int n = 0;
+
+  while(n < max && c->rxout != c->rxin)
+  {
+    p[n++] = c->rxbuf[c->rxout & (c->rxsize - 1)];
+    c->rxout++;
+  }
+  return n;
+}
+
+/*------------------------------------------------------------------------------
+  process one received frame
+ *------------------------------------------------------------------------------*/
+static void vmux_frame(struct vmux * m, const struct uart_frame * f)
+{
+  unsigned char h = (unsigned char)uart_frame_at(f, 0);
+  unsigned int i, pos, edge, len = f->n1 + f->n2;
+  struct vmux_chan * c;
+
+  if(len < 3 || (h & ~VMUX_TYPE) >= m->nch)
+    return;
+  c = &m->ch[h & ~VMUX_TYPE];
+  pos = (unsigned char)uart_frame_at(f, 1) | ((unsigned char)uart_frame_at(f, 2) << 8);
+
+  if((h & VMUX_TYPE) == VMUX_CREDIT && len == 5)
+  {
+    edge = (unsigned char)uart_frame_at(f, 3) | ((unsigned char)uart_frame_at(f, 4) << 8);
+    if(((c->txpos - pos) & 0xFFFF) > ((edge - pos) & 0xFFFF))
+      c->txpos = pos;                   /* beyond the window: the other side was restarted */
+    c->txedge = edge;
+  }
+  else if((h & VMUX_TYPE) == VMUX_DATA)
+  {
+    if(pos != c->rxpos)
+    {                                   /* lost data frame or the other side was restarted */
+      m->lost++;
+      c->rxpos = pos;
+    }
+    for(i = 3; i < len; i++)
+    {
+      if(c->rxin - c->rxout >= c->rxsize)
+      {                                 /* the other side has sent more than the credit */
+        m->ovf++;
+        break;
+      }
+      c->rxbuf[c->rxin & (c->rxsize - 1)] = uart_frame_at(f, i);
+      c->rxin++;
+    }
+    c->rxpos = (c->rxpos + len - 3) & 0xFFFF;
+  }
+}
+
+/*------------------------------------------------------------------------------
+  process the received frames, send the credits and the data
+ *------------------------------------------------------------------------------*/
+void vmux_poll(struct vmux * m, uint32_t now)
+{
+  struct uart_frame f;
+  struct vmux_chan * c;
+  unsigned char b[3 + VMUX_CHUNK];
+  unsigned int i, k, n, edge;
+  char refresh;
+
+  while(uart_frameq_get(m->d.q, &f))
+  {
+    vmux_frame(m, &f);
+    uart_frameq_free(m->d.q);
+  }
+
+  refresh = (now - m->trefresh >= VMUX_REFRESH);
+  if(refresh)
+    m->trefresh = now;
+  for(k = 0; k < m->nch; k++)
+  {                                     /* credits (if the window edge has moved at least a quarter of the RX ring or periodically) */
+    c = &m->ch[k];
+    edge = (c->rxpos + c->rxsize - (c->rxin - c->rxout)) & 0xFFFF;
+    if(refresh || ((edge - c->rxedge) & 0xFFFF) >= c->rxsize / 4)
+    {
+      b[0] = VMUX_CREDIT | k;
+      b[1] = c->rxpos & 0xFF;
+      b[2] = c->rxpos >> 8;
+      b[3] = edge & 0xFF;
+      b[4] = edge >> 8;
+      if(!cobs_send(m->tx, b, 5))
+      {                                 /* the TX buffer is full (the refresh is repeated at the next call) */
+        if(refresh)
+          m->trefresh = now - VMUX_REFRESH;
+        return;
+      }
+      c->rxedge = edge;
+    }
+  }
+
+  for(k = 0; k < m->nch; k++)
+  {                                     /* data: one chunk per channel in round-robin order */
+    c = &m->ch[m->next];
+    n = c->txin - c->txout;
+    if(n > ((c->txedge - c->txpos) & 0xFFFF))
+      n = (c->txedge - c->txpos) & 0xFFFF;
+    if(n > VMUX_CHUNK)
+      n = VMUX_CHUNK;
+    if(n)
+    {
+      b[0] = VMUX_DATA | m->next;
+      b[1] = c->txpos & 0xFF;
+      b[2] = c->txpos >> 8;
+      for(i = 0; i < n; i++)
+        b[3 + i] = c->txbuf[(c->txout + i) & (c->txsize - 1)];
+      if(!cobs_send(m->tx, b, n + 3))
+        return;                         /* the TX buffer is full (this channel is the next again) */
+      c->txout += n;
+      c->txpos = (c->txpos + n) & 0xFFFF;
+    }
+    if(++m->next >= m->nch)
+      m->next = 0;
+  }
+}
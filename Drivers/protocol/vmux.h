@@ -0,0 +1,106 @@
+#ifndef __VMUX_H__
+#define __VMUX_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* Virtual channel multiplexer over one uart
+
+   More logical streams (e.g. console, telemetry, file transfer) on one uart. Every channel
+   has an own TX and RX ring, the data is sent in channel tagged COBS frames:
+     DATA:   header (VMUX_DATA | channel), 2 characters: stream position of the first data character,
+             data (max VMUX_CHUNK characters)
+     CREDIT: header (VMUX_CREDIT | channel), 2 characters: stream position of the next expected
+             character, 2 characters: window edge (the receiver accepts the stream up to this position)
+   The stream positions are the low 16 bits of the number of the characters sent on the channel
+   (little endian). The sender of a channel sends only up to the window edge (the RX ring of the
+   other side can not overflow). The credits are absolute and they are sent again periodically,
+   so a lost frame does not stall the channel. A data frame that does not start at the expected
+   position (a lost data frame or the other side was restarted) resynchronizes the receiver, a
+   sender beyond the window of a credit (the other side was restarted) restarts at its position.
+   The channels are sent in round-robin order with max VMUX_CHUNK characters,
+   so a bulk transfer on one channel does not block the other channels.
+   The host side demultiplexer: Tools/vmux_demux.cpp
+
+   - vmux_rx: add one received character (from uartx_rxhook in the interrupt or from uartx_getchar)
+       note: e.g. char uart1_rxhook(char rxch, char err) { vmux_rx(&mux1, rxch, err); return 1; }
+
+   - vmux_write: write characters into the TX ring of the channel
+       note: return = number of the written characters (less than len if the ring is full)
+
+   - vmux_read: read characters from the RX ring of the channel
+       note: return = number of the read characters (0 = no data, not block the program from running)
+
+   - vmux_poll: process the received frames, send the credits and the data
+       note: call it periodically, now: time in ms (e.g. HAL_GetTick)
+*/
+
+#include <stdint.h>
+#include "uart_proto.h"
+#include "cobs.h"
+
+/* frame header: type (upper 3 bits), channel (lower 5 bits) */
+#define  VMUX_DATA        0x00
+#define  VMUX_CREDIT      0x20
+#define  VMUX_TYPE        0xE0
+#define  VMUX_CHMAX       32
+
+/* max data characters in one frame */
+#ifndef VMUX_CHUNK
+#define  VMUX_CHUNK       32
+#endif
+
+/* the credits of all channels are sent again after this time (ms) */
+#ifndef VMUX_REFRESH
+#define  VMUX_REFRESH     100
+#endif
+
+/* one virtual channel (the ring sizes should be (2 ^ n) and max 16384 !) */
+struct vmux_chan {
+  char * txbuf;                         /* TX ring */
+  unsigned int txsize;
+  unsigned int txin;                    /* Next In Index (vmux_write) */
+  unsigned int txout;                   /* Next Out Index (vmux_poll) */
+  char * rxbuf;                         /* RX ring */
+  unsigned int rxsize;
+  unsigned int rxin;                    /* Next In Index (vmux_poll) */
+  unsigned int rxout;                   /* Next Out Index (vmux_read) */
+  unsigned int txpos;                   /* stream position of the next sent character (16 bit) */
+  unsigned int txedge;                  /* window edge of the other side (16 bit) */
+  unsigned int rxpos;                   /* stream position of the next received character (16 bit) */
+  unsigned int rxedge;                  /* the last window edge sent to the other side (16 bit) */
+};
+
+#define  VMUX_CHAN_INIT(txbuf, rxbuf)  { txbuf, sizeof(txbuf), 0, 0, rxbuf, sizeof(rxbuf), 0, 0, 0, 0, 0, 0 }
+
+/* multiplexer */
+struct vmux {
+  const struct uart_txport * tx;        /* TX port */
+  struct cobs_rx d;                     /* COBS decoder of the received frames */
+  struct vmux_chan * ch;                /* channels */
+  unsigned int nch;                     /* number of channels (max VMUX_CHMAX) */
+  unsigned int next;                    /* next channel of the round-robin */
+  uint32_t trefresh;                    /* time of the last sending of all credits */
+  unsigned int ovf;                     /* Number of data frames larger than the credit */
+  unsigned int lost;                    /* Number of resynchronizations (lost data frames) */
+};
+
+/* q: frame queue of the received frames, ch: struct vmux_chan array */
+#define  VMUX_INIT(tx, q, ch)  { tx, COBS_RX_INIT(q), ch, sizeof(ch) / sizeof(ch[0]), 0, 0, 0, 0 }
+
+static inline void vmux_rx(struct vmux * m, char c, char err)
+{
+  cobs_rx(&m->d, c, err);
+}
+
+unsigned int vmux_write(struct vmux * m, unsigned int ch, const void * buf, unsigned int len);
+unsigned int vmux_read(struct vmux * m, unsigned int ch, void * buf, unsigned int max);
+void     vmux_poll(struct vmux * m, uint32_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __VMUX_H__ */
@@ -0,0 +1,101 @@
+/* Pipelined request/response transaction engine for the uart driver */
+
+#include <string.h>
+#include "main.h"
+#include "xact.h"
+
+/*------------------------------------------------------------------------------
+  send the raw characters (without framing layer)
+ *------------------------------------------------------------------------------*/
+static char xact_rawsend(const struct uart_txport * port, const void * buf, unsigned int len)
+{
+  struct uart_txspan ts;
+
+  if(!uart_txport_reserve(port, len, &ts))
+    return 0;
+  memcpy(ts.p1, buf, ts.n1);
+  memcpy(ts.p2, (const char *)buf + ts.n1, ts.n2);
+  port->commit();
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  send a request and open a transaction
+  return: 1 = the request has been sent, 0 = no free slot or the TX buffer is full
+ *------------------------------------------------------------------------------*/
+char xact_request(struct xact * x, unsigned int key, const void * buf, unsigned int len, unsigned int timeout, unsigned int now, void * user)
+{
+  struct xact_slot * s;
+  unsigned int i;
+
+  for(i = 0; i < x->nslots && x->slots[i].busy; i++);
+  if(i == x->nslots)
+    return 0;                           /* too many requests in flight */
+
+  if(!(x->send ? x->send(x->tx, buf, len) : xact_rawsend(x->tx, buf, len)))
+    return 0;
+
+  s = &x->slots[i];
+  s->key = key;
+  s->deadline = now + timeout;
+  s->seq = x->seq++;
+  s->user = user;
+  s->busy = 1;
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  process the received replies and the expired transactions
+ *------------------------------------------------------------------------------*/
+void xact_poll(struct xact * x, unsigned int now)
+{
+  struct uart_frame f;
+  struct xact_slot * s, * m;
+  unsigned int i, key;
+  void * user;
+
+  while(uart_frameq_get(x->q, &f))
+  {
+    m = 0;
+    if(x->keyof(&f, &key))
+      for(i = 0; i < x->nslots; i++)
+      {                                 /* the oldest open transaction with this key */
+        s = &x->slots[i];
+        if(s->busy && s->key == key && (!m || (int)(s->seq - m->seq) < 0))
+          m = s;
+      }
+    if(m)
+    {
+      user = m->user;
+      m->busy = 0;                      /* the slot can be reused from the callback */
+      x->cb(x, user, &f);
+    }
+    else
+      x->unmatched++;
+    uart_frameq_free(x->q);
+  }
+
+  for(i = 0; i < x->nslots; i++)
+  {
+    s = &x->slots[i];
+    if(s->busy && (int)(now - s->deadline) >= 0)
+    {                                   /* timeout */
+      s->busy = 0;
+      x->timeouts++;
+      x->cb(x, s->user, 0);
+    }
+  }
+}
+
+/*------------------------------------------------------------------------------
+  number of the open transactions
+ *------------------------------------------------------------------------------*/
+unsigned int xact_pending(const struct xact * x)
+{
+  unsigned int i, n = 0;
+
+  for(i = 0; i < x->nslots; i++)
+    if(x->slots[i].busy)
+      n++;
+  return n;
+}
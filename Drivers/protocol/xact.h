@@ -0,0 +1,72 @@
+#ifndef __XACT_H__
+#define __XACT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* Pipelined request/response transaction engine for the uart driver (master side)
+
+   More requests can be in flight at the same time on one uart. Every request has a key
+   (e.g. slave address + function code, sequence number), the key of the reply is given by a
+   user function, the reply completes the oldest open request with the same key.
+   The requests without reply are completed with timeout.
+
+   - struct xact: engine of one uart
+       tx: TX port of the uart
+       send: framing layer (e.g. cobs_send, slip_send, hdlc_send, mbrtu_send), 0 = raw characters
+       q: frame queue of the replies (filled by the decoder of the framing layer)
+       slots: open transactions (the number of slots = max number of requests in flight)
+       keyof: key extractor, char keyof(const struct uart_frame * f, unsigned int * key)
+              if return = 0 -> the frame is not a reply (dropped)
+       cb: completion, void cb(struct xact * x, void * user, const struct uart_frame * f)
+              f = 0 -> timeout
+
+   - xact_request: send a request and open a transaction
+       note: timeout and now in the same time unit (e.g. ms with HAL_GetTick)
+             if return = 0 -> no free slot or the TX buffer is full (the request is not sent)
+
+   - xact_poll: process the received replies and the expired transactions (call it periodically)
+       note: the callbacks are called from xact_poll (not from the interrupt)
+
+   - xact_pending: number of the open transactions
+*/
+
+#include "uart_proto.h"
+
+/* open transaction */
+struct xact_slot {
+  unsigned int key;                     /* key of the expected reply */
+  unsigned int deadline;                /* timeout time */
+  unsigned int seq;                     /* order of the requests (the oldest is completed first) */
+  void * user;                          /* user data of the request */
+  unsigned char busy;                   /* NZ: open transaction */
+};
+
+/* engine */
+struct xact {
+  const struct uart_txport * tx;        /* TX port */
+  char (*send)(const struct uart_txport * port, const void * buf, unsigned int len);
+  struct uart_frameq * q;               /* replies */
+  struct xact_slot * slots;             /* open transactions */
+  unsigned int nslots;                  /* number of slots */
+  char (*keyof)(const struct uart_frame * f, unsigned int * key);
+  void (*cb)(struct xact * x, void * user, const struct uart_frame * f);
+  unsigned int seq;                     /* sequence counter */
+  unsigned int unmatched;               /* Number of replies without open transaction */
+  unsigned int timeouts;                /* Number of expired transactions */
+};
+
+/* slots: struct xact_slot array */
+#define  XACT_INIT(tx, send, q, slots, keyof, cb)  { tx, send, q, slots, sizeof(slots) / sizeof(slots[0]), keyof, cb, 0, 0, 0 }
+
+char     xact_request(struct xact * x, unsigned int key, const void * buf, unsigned int len, unsigned int timeout, unsigned int now, void * user);
+void     xact_poll(struct xact * x, unsigned int now);
+unsigned int xact_pending(const struct xact * x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __XACT_H__ */
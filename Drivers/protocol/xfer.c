@@ -0,0 +1,367 @@
+/* Sliding window file transfer with selective retransmit */
+
+#include "main.h"
+#include "xfer.h"
+#include "uart_crc.h"
+
+#define  XFER_WMASK   ((XFER_WINDOW >= 32) ? 0xFFFFFFFF : ((1UL << XFER_WINDOW) - 1))
+
+#if XFER_WINDOW < 2 || XFER_WINDOW > 32
+#error "XFER_WINDOW must be 2..32"
+#endif
+
+static inline void xfer_put16(unsigned char * p, uint32_t v)
+{
+  p[0] = v;
+  p[1] = v >> 8;
+}
+
+static inline void xfer_put32(unsigned char * p, uint32_t v)
+{
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+static inline uint32_t xfer_get(const struct uart_frame * f, unsigned int i, unsigned int n)
+{
+  uint32_t v = 0;
+  while(n--)
+    v = (v << 8) | (unsigned char)uart_frame_at(f, i + n);
+  return v;
+}
+
+/*------------------------------------------------------------------------------
+  send the frame in x->buf (len: without the CRC)
+  return: 0 = the TX buffer is full (not sent)
+ *------------------------------------------------------------------------------*/
+static char xfer_frame(struct xfer * x, unsigned int len)
+{
+  struct uart_txspan ts;
+
+  xfer_put32(&x->buf[len], ~crc32(UART_CRC32_INIT, x->buf, len));
+  len += 4;
+  if(!x->tx->reserve(cobs_enclen(x->buf, len), &ts))
+    return 0;
+  cobs_encode(&ts, x->buf, len);
+  x->tx->commit();
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  send a data block
+ *------------------------------------------------------------------------------*/
+static char xfer_block(struct xfer * x, uint32_t blk, uint32_t now)
+{
+  uint32_t ofs = blk * XFER_BLOCK;
+  unsigned int len = (x->tsize - ofs < XFER_BLOCK) ? x->tsize - ofs : XFER_BLOCK;
+
+  x->buf[0] = 'D';
+  xfer_put16(&x->buf[1], blk);
+  if(!x->read(ofs, (char *)&x->buf[3], len))
+  {                                     /* read error: the next try after XFER_RTO */
+    x->treaderr++;
+    x->ttime = now;
+    return 0;
+  }
+  x->treaderr = 0;
+  if(!xfer_frame(x, 3 + len))
+    return 0;
+  x->tsent[blk % XFER_WINDOW] = now;
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  end of the sending
+ *------------------------------------------------------------------------------*/
+static void xfer_tdone(struct xfer * x, char ok)
+{
+  x->tstate = 0;
+  if(x->done)
+    x->done(x, 1, ok);
+}
+
+/*------------------------------------------------------------------------------
+  start sending a file
+ *------------------------------------------------------------------------------*/
+char xfer_send(struct xfer * x, uint32_t size, uint32_t now)
+{
+  if(x->tstate)
+    return 0;
+  x->tsize = size;
+  x->tn = (size + XFER_BLOCK - 1) / XFER_BLOCK;
+  x->tbase = 0;
+  x->tnext = 0;
+  x->tacked = 0;
+  x->tfast = 0;
+  x->tresend = 0;
+  x->tretry = 0;
+  x->treaderr = 0;
+  x->ttime = now - XFER_RTO;            /* the start frame is sent immediately */
+  x->tstate = 1;
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  acknowledge received (sender side)
+ *------------------------------------------------------------------------------*/
+static void xfer_ack(struct xfer * x, uint32_t base16, uint32_t bits, uint32_t now)
+{
+  uint32_t base = x->tbase + (int16_t)(base16 - (uint16_t)x->tbase);
+  unsigned int i, sh;
+
+  if(x->tstate == 1)
+  {
+    if(base16 != 0)
+      return;                           /* old acknowledge */
+    x->tstate = 2;
+    x->tretry = 0;
+  }
+  if(x->tstate == 3)
+  {
+    if(base == x->tn)
+      xfer_tdone(x, 1);
+    return;
+  }
+  if(x->tstate != 2 || (int32_t)(base - x->tbase) < 0 || (int32_t)(base - x->tnext) > 0)
+    return;
+
+  if(base != x->tbase)
+  {                                     /* progress */
+    sh = base - x->tbase;
+    x->tacked = (sh >= 32) ? 0 : x->tacked >> sh;
+    x->tfast = (sh >= 32) ? 0 : x->tfast >> sh;
+    x->tresend = (sh >= 32) ? 0 : x->tresend >> sh;
+    x->tbase = base;
+    x->tretry = 0;
+  }
+  x->tacked |= (bits << 1) & XFER_WMASK & ((x->tnext - x->tbase >= 32) ? 0xFFFFFFFF : (1UL << (x->tnext - x->tbase)) - 1);
+
+  for(i = XFER_WINDOW - 1; i > 0 && !(x->tacked & (1UL << i)); i--);
+  while(i--)
+  {                                     /* fast retransmit: the blocks before the last acknowledged block */
+    if(!(x->tacked & (1UL << i)) && !(x->tfast & (1UL << i)))
+    {
+      x->tfast |= 1UL << i;
+      x->tresend |= 1UL << i;
+    }
+  }
+
+  if(x->tbase == x->tn)
+  {
+    x->tstate = 3;
+    x->ttime = now - XFER_RTO;          /* the end frame is sent immediately */
+    x->tretry = 0;
+  }
+}
+
+/*------------------------------------------------------------------------------
+  sender: start / end frame, retransmits, new blocks
+ *------------------------------------------------------------------------------*/
+static void xfer_tpoll(struct xfer * x, uint32_t now)
+{
+  uint32_t i, m;
+
+  if(x->tstate == 1 || x->tstate == 3)
+  {
+    if(now - x->ttime < XFER_RTO)
+      return;
+    if(++x->tretry > XFER_RETRIES + 1)
+    {
+      xfer_tdone(x, 0);
+      return;
+    }
+    if(x->tstate == 1)
+    {
+      x->buf[0] = 'S';
+      xfer_put32(&x->buf[1], x->tsize);
+      if(xfer_frame(x, 5))
+        x->ttime = now;
+    }
+    else
+    {
+      x->buf[0] = 'E';
+      if(xfer_frame(x, 1))
+        x->ttime = now;
+    }
+    return;
+  }
+
+  if(x->tstate != 2)
+    return;
+
+  if(x->treaderr)
+  {                                     /* the read callback failed */
+    if(now - x->ttime < XFER_RTO)
+      return;
+    if(x->treaderr > XFER_RETRIES)
+    {
+      xfer_tdone(x, 0);
+      return;
+    }
+  }
+
+  for(i = 0; i < x->tnext - x->tbase; i++)
+  {                                     /* retransmits */
+    m = 1UL << i;
+    if(x->tacked & m)
+      continue;
+    if(!(x->tresend & m) && now - x->tsent[(x->tbase + i) % XFER_WINDOW] < XFER_RTO)
+      continue;
+    if(!(x->tresend & m) && i == 0 && ++x->tretry > XFER_RETRIES)
+    {
+      xfer_tdone(x, 0);
+      return;
+    }
+    if(!xfer_block(x, x->tbase + i, now))
+      return;                           /* the TX buffer is full */
+    x->tresend &= ~m;
+    x->retrans++;
+  }
+
+  while(x->tnext < x->tn && x->tnext - x->tbase < XFER_WINDOW)
+  {                                     /* new blocks */
+    if(!xfer_block(x, x->tnext, now))
+      return;
+    x->tnext++;
+  }
+}
+
+/*------------------------------------------------------------------------------
+  receiver: write the data of the frame into the file
+ *------------------------------------------------------------------------------*/
+static char xfer_write(struct xfer * x, const struct uart_frame * f, uint32_t ofs, unsigned int len)
+{
+  unsigned int n;
+
+  if(f->n1 > 3)
+  {                                     /* first part (after the header) */
+    n = (f->n1 - 3 < len) ? f->n1 - 3 : len;
+    if(!x->write(ofs, f->p1 + 3, n))
+      return 0;
+    ofs += n;
+    len -= n;
+    return !len || x->write(ofs, f->p2, len);
+  }
+  return x->write(ofs, f->p2 + (3 - f->n1), len);
+}
+
+/*------------------------------------------------------------------------------
+  receiver: data frame
+ *------------------------------------------------------------------------------*/
+static void xfer_data(struct xfer * x, const struct uart_frame * f, unsigned int len)
+{
+  uint32_t blk = x->rbase + (int16_t)(xfer_get(f, 1, 2) - (uint16_t)x->rbase);
+  uint32_t rel = blk - x->rbase;
+
+  x->rack = 1;
+  if(x->rstate != 1 || (int32_t)rel < 0 || rel > 32 || blk >= x->rn)
+    return;                             /* old or out of the window */
+  if(rel && (x->rbits & (1UL << (rel - 1))))
+    return;                             /* already received */
+  if(len - 3 != ((blk == x->rn - 1) ? x->rsize - blk * XFER_BLOCK : XFER_BLOCK))
+  {
+    x->crcerr++;
+    return;
+  }
+  if(!xfer_write(x, f, blk * XFER_BLOCK, len - 3))
+    return;
+
+  if(rel)
+    x->rbits |= 1UL << (rel - 1);
+  else
+  {
+    x->rbase++;
+    while(x->rbits & 1)
+    {
+      x->rbits >>= 1;
+      x->rbase++;
+    }
+    x->rbits >>= 1;
+  }
+}
+
+/*------------------------------------------------------------------------------
+  process one received frame
+ *------------------------------------------------------------------------------*/
+static void xfer_rxframe(struct xfer * x, const struct uart_frame * f, uint32_t now)
+{
+  unsigned int len = f->n1 + f->n2;
+  uint32_t crc, size;
+
+  if(len < 5)
+  {
+    x->crcerr++;
+    return;
+  }
+  len -= 4;
+  crc = crc32(crc32(UART_CRC32_INIT, f->p1, (f->n1 < len) ? f->n1 : len), f->p2, (f->n1 < len) ? len - f->n1 : 0);
+  if(~crc != xfer_get(f, len, 4))
+  {
+    x->crcerr++;
+    return;
+  }
+
+  switch(uart_frame_at(f, 0))
+  {
+    case 'S':
+      if(len != 5)
+        break;
+      size = xfer_get(f, 1, 4);
+      if(!(x->rstate == 1 && x->rsize == size && !x->rbase && !x->rbits))
+      {                                 /* new file (not a repeated start frame) */
+        if(x->start && !x->start(x, size))
+          break;
+        x->rstate = 1;
+        x->rsize = size;
+        x->rn = (size + XFER_BLOCK - 1) / XFER_BLOCK;
+        x->rbase = 0;
+        x->rbits = 0;
+      }
+      x->rack = 1;
+      break;
+    case 'D':
+      if(len >= 3)
+        xfer_data(x, f, len);
+      break;
+    case 'E':
+      if(x->rstate == 1 && x->rbase == x->rn)
+      {
+        x->rstate = 0;
+        if(x->done)
+          x->done(x, 0, 1);
+      }
+      x->rack = 1;
+      break;
+    case 'A':
+      if(len == 7)
+        xfer_ack(x, xfer_get(f, 1, 2), xfer_get(f, 3, 4), now);
+      break;
+  }
+}
+
+/*------------------------------------------------------------------------------
+  process the received frames, send the blocks and the acknowledges
+ *------------------------------------------------------------------------------*/
+void xfer_poll(struct xfer * x, uint32_t now)
+{
+  struct uart_frame f;
+
+  while(uart_frameq_get(x->d.q, &f))
+  {
+    xfer_rxframe(x, &f, now);
+    uart_frameq_free(x->d.q);
+  }
+
+  if(x->rack)
+  {                                     /* one acknowledge for all frames received since the last poll */
+    x->buf[0] = 'A';
+    xfer_put16(&x->buf[1], x->rbase);
+    xfer_put32(&x->buf[3], x->rbits);
+    if(xfer_frame(x, 7))
+      x->rack = 0;
+  }
+
+  xfer_tpoll(x, now);
+}
@@ -0,0 +1,119 @@
+#ifndef __XFER_H__
+#define __XFER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+/* Sliding window file transfer with selective retransmit
+
+   The file is sent in 1 kbyte blocks, more blocks are in flight at the same time (window),
+   the receiver acknowledges the received blocks one by one (cumulative + bitmap), so only the
+   lost or broken blocks are sent again. The blocks are read from and written to the storage
+   directly by the user callbacks (the receiver writes the blocks in the order of arrival).
+   The host side peer: Tools/xfer_peer.cpp
+
+   Frames (COBS, every frame ends with CRC-32 little endian):
+     'S' size (4):              start, file size
+     'D' seq (2) data (max 1024): data block, seq = block number (lower 16 bits)
+     'E':                       end of the file
+     'A' base (2) bits (4):     acknowledge, base = number of the blocks received in order,
+                                bits: bit n = 1 -> the block base + 1 + n is received
+   (the numbers are little endian)
+
+   - xfer_rx: add one received character (from uartx_rxhook in the interrupt or from uartx_getchar)
+       note: e.g. char uart1_rxhook(char rxch, char err) { xfer_rx(&xf1, rxch, err); return 1; }
+             the frame queue should hold at least 2 full frames (e.g. 4096 bytes)
+
+   - xfer_send: start sending a file (size: file size in bytes)
+       note: return = 0 -> a sending is in progress
+
+   - xfer_poll: process the received frames, send the blocks, the retransmits and the acknowledges
+       note: call it often, now: time in ms (e.g. HAL_GetTick)
+             the TX buffer should hold at least 2 full frames (e.g. 4096 bytes), the blocks are written
+             only if there is enough space (xfer_poll does not wait)
+
+   - callbacks:
+       read:  char read(uint32_t ofs, char * buf, unsigned int len): read from the file to send
+              (1 = ok, 0 = error: it is called again after XFER_RTO, the sending is aborted (done, ok = 0)
+              if it fails XFER_RETRIES more times in succession)
+       write: char write(uint32_t ofs, const char * buf, unsigned int len): write into the received file
+              (1 = ok, 0 = the block is dropped and it will be sent again)
+       start: char start(struct xfer * x, uint32_t size): a file is coming (1 = accepted), optional
+       done:  void done(struct xfer * x, char dir, char ok): end of the transfer
+              (dir: 0 = receive, 1 = send, ok: 1 = complete, 0 = aborted)
+*/
+
+#include <stdint.h>
+#include "uart_proto.h"
+#include "cobs.h"
+
+#define  XFER_BLOCK       1024
+
+/* max number of the blocks in flight (2..32) */
+#ifndef XFER_WINDOW
+#define  XFER_WINDOW      8
+#endif
+
+/* retransmit timeout (ms) and the number of retries without progress */
+#ifndef XFER_RTO
+#define  XFER_RTO         500
+#endif
+#ifndef XFER_RETRIES
+#define  XFER_RETRIES     10
+#endif
+
+#define  XFER_FRAME_MAX   (1 + 2 + XFER_BLOCK + 4)
+
+struct xfer {
+  const struct uart_txport * tx;        /* TX port */
+  struct cobs_rx d;                     /* COBS decoder of the received frames */
+  char (*read)(uint32_t ofs, char * buf, unsigned int len);
+  char (*write)(uint32_t ofs, const char * buf, unsigned int len);
+  char (*start)(struct xfer * x, uint32_t size);
+  void (*done)(struct xfer * x, char dir, char ok);
+
+  /* sender */
+  unsigned char tstate;                 /* 0 = idle, 1 = start, 2 = data, 3 = end */
+  uint32_t tsize;                       /* file size */
+  uint32_t tn;                          /* number of the blocks */
+  uint32_t tbase;                       /* the blocks before tbase are acknowledged */
+  uint32_t tnext;                       /* next new block */
+  uint32_t tacked;                      /* bit n = 1: the block tbase + n is acknowledged */
+  uint32_t tfast;                       /* bit n = 1: the block tbase + n has been sent again after a gap */
+  uint32_t tresend;                     /* bit n = 1: the block tbase + n must be sent again */
+  uint32_t tsent[XFER_WINDOW];          /* send time of the blocks in the window (index: block % XFER_WINDOW) */
+  uint32_t ttime;                       /* send time of the start / end frame, time of the last read error */
+  unsigned int tretry;                  /* number of timeouts without progress */
+  unsigned int treaderr;                /* number of the successive read errors */
+
+  /* receiver */
+  unsigned char rstate;                 /* 0 = idle, 1 = receiving */
+  uint32_t rsize;                       /* file size */
+  uint32_t rn;                          /* number of the blocks */
+  uint32_t rbase;                       /* the blocks before rbase are received */
+  uint32_t rbits;                       /* bit n = 1: the block rbase + 1 + n is received */
+  unsigned char rack;                   /* NZ: acknowledge must be sent */
+
+  unsigned int retrans;                 /* Number of the retransmitted blocks */
+  unsigned int crcerr;                  /* Number of the broken frames */
+  unsigned char buf[XFER_FRAME_MAX];    /* frame buffer */
+};
+
+/* q: frame queue of the received frames */
+#define  XFER_INIT(tx, q, read, write, start, done)  { tx, COBS_RX_INIT(q), read, write, start, done }
+
+static inline void xfer_rx(struct xfer * x, char c, char err)
+{
+  cobs_rx(&x->d, c, err);
+}
+
+char     xfer_send(struct xfer * x, uint32_t size, uint32_t now);
+void     xfer_poll(struct xfer * x, uint32_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __XFER_H__ */
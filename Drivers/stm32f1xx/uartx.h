@@ -13,6 +13,16 @@
 #define UARTX_TX  X, 0
 #endif
 
+/* baud rate divider (rounded to the nearest) and the actual baud rate */
+#define UARTX_BRR_CALC        (((UARTX_CLK) + UARTX_BAUDRATE / 2) / UARTX_BAUDRATE)
+#define UARTX_BAUD_ACT        (((UARTX_CLK) + UARTX_BRR_CALC / 2) / UARTX_BRR_CALC)
+
+/* compile time check of the baud rate error (only if the uart clock is a constant) */
+_Static_assert(__builtin_choose_expr(__builtin_constant_p(UARTX_CLK),
+               UARTX_BRR_CALC >= 16 && (UARTX_BAUD_ACT > UARTX_BAUDRATE ? UARTX_BAUD_ACT - UARTX_BAUDRATE : UARTX_BAUDRATE - UARTX_BAUD_ACT) * 10000ULL
+               <= (unsigned long long)UART_BAUD_TOLERANCE * UARTX_BAUDRATE, 1),
+               "the baud rate error is larger than UART_BAUD_TOLERANCE (see uart.h)");
+
 #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A
 struct bufx_r {
   unsigned int in;                      /* Next In Index */
@@ -23,21 +33,55 @@ volatile static struct bufx_r rbufx = { 0, 0, };
 #define FIFO_RBUFLEN ((unsigned int)(rbufx.in - rbufx.out))
 __weak void uartx_cbrx(char rxch) { }
 __weak void uartx_cbrxof(void)  { }
+__weak void uartx_cbrto(void)  { }
+#if UARTX_MUTE > 0
+/* mute mode (multiprocessor communication) */
+static volatile unsigned char rxx_addr = 0;    /* node address */
+static volatile unsigned char rxx_mutereq = 0; /* NZ: enter the mute mode (requested by uartx_mute) */
+static unsigned char rxx_first = 0;            /* NZ: the next character is the address (after the idle line) */
+#endif
+/* receiver timeout (software, with the DWT cycle counter) */
+static unsigned int rtox_cycles = 0;    /* timeout (cpu cycles), 0 = off */
+static volatile unsigned int rtox_last; /* DWT->CYCCNT at the last received character */
+static volatile unsigned int rtox_armed = 0; /* NZ: character received, the timeout is not expired */
 #endif
 
 #if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A
-static volatile unsigned int txx_restart = 1; /* NZ if TX restart is required */
+/* NZ if TX restart is required
+   only the interrupt writes it and the USART_CR1_TXEIE bit, uartx_sendchar only pends the interrupt,
+   so there is no read-modify-write of CR1 outside the interrupt (no lost TX start) */
+static volatile unsigned int txx_restart = 1;
 struct bufx_t {
-  unsigned int in;                      /* Next In Index */
+  unsigned int in;                      /* Next In Index (published to the interrupt) */
   unsigned int out;                     /* Next Out Index */
+  unsigned int res;                     /* Next Reserved Index */
+  unsigned int nest;                    /* Number of open reservations */
+  #if URGBUFX_SIZE >= 4
+  unsigned int cont [(TXBUFX_SIZE + 31) / 32]; /* Message continue bits (see txx_msgmark) */
+  #endif
   char buf [TXBUFX_SIZE];               /* Buffer */
 };
-volatile static struct bufx_t tbufx = { 0, 0, };
+volatile static struct bufx_t tbufx = { 0, 0, 0, 0, };
 #define FIFO_TBUFLEN ((unsigned int)(tbufx.in - tbufx.out))
+
+#if URGBUFX_SIZE >= 4
+struct bufx_u {
+  unsigned int in;                      /* Next In Index (published to the interrupt) */
+  unsigned int out;                     /* Next Out Index */
+  unsigned int res;                     /* Next Reserved Index */
+  unsigned int nest;                    /* Number of open reservations */
+  char buf [URGBUFX_SIZE];              /* Buffer */
+};
+volatile static struct bufx_u ubufx = { 0, 0, 0, 0, };
+static volatile unsigned int txx_urgent = 0; /* NZ if the interrupt sends an urgent message */
+static volatile unsigned int txx_inmsg = 0;  /* NZ if the last character sent from tbufx is not the end of its message */
+#endif
 #endif
 
 void uartx_init(void);
+#if UARTX_LAZY_INIT == 1
 static unsigned int uartx_inited = 0;  /* 0: not intit (call the uart_init), 1: after init */
+#endif
 
 
 /*----------------------------------------------------------------------------
@@ -50,40 +94,116 @@ void UARTX_IRQHandler(void)
 
   usr = UARTX->SR;
 
+  #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && UARTX_MUTE > 0
+  if (rxx_mutereq)
+  {                                     /* enter the mute mode (requested by uartx_mute) */
+    rxx_mutereq = 0;
+    UARTX->CR2 = (UARTX->CR2 & ~USART_CR2_ADD) | (rxx_addr & 0x0F); /* the hardware compares 4 bits */
+    rxx_first = 1;
+    UARTX->CR1 |= USART_CR1_RWU;
+  }
+  #endif
+
   #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A
   unsigned int udr;
   if (usr & USART_SR_RXNE)
   {                                     /* RX */
     udr = UARTX->DR;
     UARTX->SR &= ~USART_SR_RXNE;        /* clear interrupt */
-    uartx_cbrx((unsigned char)udr);
-    if(!(usr & (USART_SR_ORE | USART_SR_NE | USART_SR_FE)))
+    if (rtox_cycles)
+    {                                   /* receiver timeout: time of the last character */
+      rtox_last = DWT->CYCCNT;
+      rtox_armed = 1;
+    }
+    #if UARTX_MUTE > 0
+    if (rxx_first || (udr & 0x100))
+    {                                   /* address character (after the idle line or with the 9th bit) */
+      rxx_first = ((unsigned char)udr != rxx_addr); /* not for this node: the first character after the wakeup is an address */
+      if (rxx_first)
+        UARTX->CR1 |= USART_CR1_RWU; /* mute to the next address (the wakeup by idle line does not set IDLE) */
+    }
+    else
+    #endif
     {
-      if (((rbufx.in - rbufx.out) & ~(RXBUFX_SIZE - 1)) == 0)
+      uartx_cbrx((unsigned char)udr);
+      #if UARTX_RXHOOK == 1
+      if(uartx_rxhook((char)udr, (usr & (USART_SR_ORE | USART_SR_NE | USART_SR_FE)) ? 1 : 0))
+        ;                                 /* processed by the hook (not stored in the RX buffer) */
+      else
+      #endif
+      if(!(usr & (USART_SR_ORE | USART_SR_NE | USART_SR_FE)))
       {
-        rbufx.buf [rbufx.in & (RXBUFX_SIZE - 1)] = (char)udr;
-        rbufx.in++;
+        if (((rbufx.in - rbufx.out) & ~(RXBUFX_SIZE - 1)) == 0)
+        {
+          rbufx.buf [rbufx.in & (RXBUFX_SIZE - 1)] = (char)udr;
+          rbufx.in++;
+        }
+        else
+          uartx_cbrxof();                 /* buffer overflow! */
       }
-      else
-        uartx_cbrxof();                 /* buffer overflow! */
     }
   }
   #endif
 
+  #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A
+  if (rtox_armed && (DWT->CYCCNT - rtox_last >= rtox_cycles))
+  {                                     /* receiver timeout (the interrupt was pended by uartx_rtopoll) */
+    rtox_armed = 0;
+    uartx_cbrto();
+  }
+  #endif
+
+  #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && UARTX_MUTE == 2
+  if ((usr & USART_SR_IDLE) && !(usr & USART_SR_RXNE))
+  {                                     /* idle line: the next character is the address */
+    (void)UARTX->DR;                    /* clear IDLE */
+    rxx_first = 1;
+  }
+  #endif
+
   #if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A
   if (usr & USART_SR_TXE)
   {                                     /* TX */
     UARTX->SR &= ~USART_SR_TXE;         /* clear interrupt */
+    #if URGBUFX_SIZE >= 4
+    if ((ubufx.in != ubufx.out) && (txx_urgent || !txx_inmsg || (tbufx.in == tbufx.out)))
+    {                                   /* urgent message first (only at a message boundary of tbufx) */
+      UARTX->DR = ubufx.buf [ubufx.out & (URGBUFX_SIZE - 1)] & 0x00FF;
+      ubufx.out++;
+      txx_urgent = 1;
+      if (txx_restart)
+      {                                 /* TX restart (the interrupt was pended by uartx_send_urgent) */
+        txx_restart = 0;
+        UARTX->CR1 |= USART_CR1_TXEIE;  /* enable TX interrupt */
+      }
+    }
+    else
+    #endif
     if (tbufx.in != tbufx.out)
     {
+      #if URGBUFX_SIZE >= 4
+      txx_urgent = 0;
+      txx_inmsg = (tbufx.cont [(tbufx.out & (TXBUFX_SIZE - 1)) >> 5] >> (tbufx.out & (TXBUFX_SIZE - 1) & 31)) & 1;
+      #endif
       UARTX->DR = tbufx.buf [tbufx.out & (TXBUFX_SIZE - 1)] & 0x00FF;
       tbufx.out++;
-      txx_restart = 0;
+      if (txx_restart)
+      {                                 /* TX restart (the interrupt was pended by uartx_sendchar) */
+        txx_restart = 0;
+        UARTX->CR1 |= USART_CR1_TXEIE;  /* enable TX interrupt */
+      }
     }
-    else
+    else if (!txx_restart)
     {
       txx_restart = 1;
       UARTX->CR1 &= ~USART_CR1_TXEIE;   /* disable TX interrupt if nothing to send */
+      /* a higher priority producer can publish between the check and txx_restart = 1 (it does not pend) */
+      #if URGBUFX_SIZE >= 4
+      if ((tbufx.in != tbufx.out) || (ubufx.in != ubufx.out))
+      #else
+      if (tbufx.in != tbufx.out)
+      #endif
+        NVIC->ISPR[(((uint32_t)(int32_t)UARTX_IRQn) >> 5UL)] = (uint32_t)(1UL << (((uint32_t)(int32_t)UARTX_IRQn) & 0x1FUL));
     }
   }
   #endif
@@ -95,11 +215,10 @@ void UARTX_IRQHandler(void)
 #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A
 char uartx_getchar(char * c)
 {
+  #if UARTX_LAZY_INIT == 1
   if(!uartx_inited)
-  {
     uartx_init();
-    uartx_inited = 1;
-  }
+  #endif
 
   if (rbufx.in == rbufx.out)
     return 0;                           /* empty */
@@ -113,39 +232,256 @@ char uartx_getchar(char * c) { return 0; }
 #endif
 
 /*------------------------------------------------------------------------------
-  transmit a character
+  receiver timeout (software: this family does not have RTOR)
+  - bits: timeout after the last received character in bit time (0 = off)
+  note: uartx_rtopoll must be called periodically (e.g. from a timer interrupt),
+        when it expires, uartx_cbrto is called from the uart interrupt
  *------------------------------------------------------------------------------*/
-#if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A
-char uartx_sendchar(char c)
+#if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A
+void uartx_rtoset(unsigned int bits)
 {
+  #if UARTX_LAZY_INIT == 1
   if(!uartx_inited)
+    uartx_init();
+  #endif
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  rtox_armed = 0;
+  rtox_cycles = bits * (SystemCoreClock / UARTX_BAUDRATE);
+}
+
+/* check the receiver timeout in the uart interrupt (pend it if a character was received) */
+void uartx_rtopoll(void)
+{
+  if (rtox_armed)
+    NVIC->ISPR[(((uint32_t)(int32_t)UARTX_IRQn) >> 5UL)] = (uint32_t)(1UL << (((uint32_t)(int32_t)UARTX_IRQn) & 0x1FUL));
+}
+#else
+void uartx_rtoset(unsigned int bits) { }
+void uartx_rtopoll(void) { }
+#endif
+
+/*------------------------------------------------------------------------------
+  enter the mute mode (the frames of the other nodes are discarded by the hardware)
+  - addr: node address
+  note: the mute mode is set in the interrupt (only the interrupt writes CR1)
+ *------------------------------------------------------------------------------*/
+#if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && UARTX_MUTE > 0
+void uartx_mute(unsigned char addr)
+{
+  #if UARTX_LAZY_INIT == 1
+  if(!uartx_inited)
+    uartx_init();
+  #endif
+
+  rxx_addr = addr;
+  rxx_mutereq = 1;
+  NVIC->ISPR[(((uint32_t)(int32_t)UARTX_IRQn) >> 5UL)] = (uint32_t)(1UL << (((uint32_t)(int32_t)UARTX_IRQn) & 0x1FUL));
+}
+#else
+void uartx_mute(unsigned char addr) { }
+#endif
+
+/*------------------------------------------------------------------------------
+  mark the message boundary in tbufx.cont (bit = 1: the message continues, 0: last character)
+ *------------------------------------------------------------------------------*/
+#if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A && URGBUFX_SIZE >= 4
+static void txx_msgmark(unsigned int pos, unsigned int len)
+{
+  unsigned int i, n, m;
+  while(len)
   {
+    i = pos & (TXBUFX_SIZE - 1);
+    n = 32 - (i & 31);                  /* to the end of the 32 bit word or the buffer */
+    if(n > TXBUFX_SIZE - i)
+      n = TXBUFX_SIZE - i;
+    if(n > len)
+      n = len;
+    m = (n == 32) ? 0xFFFFFFFF : ((1U << n) - 1) << (i & 31);
+    uart_atomic_bits(&tbufx.cont[i >> 5], m, (n == len) ? m & ~(1U << ((i + n - 1) & 31)) : m);
+    pos += n;
+    len -= n;
+  }
+}
+#endif
+
+/*------------------------------------------------------------------------------
+  close a reservation of a TX buffer (tbufx or ubufx)
+  the last closed reservation publishes all reserved areas to the interrupt
+  return: number of the reservations still open
+ *------------------------------------------------------------------------------*/
+#if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A
+static unsigned int txx_commit(volatile unsigned int * nest, volatile unsigned int * in, volatile unsigned int * res)
+{
+  unsigned int n;
+  __DMB();                              /* the characters are in the buffer before publishing */
+  n = uart_atomic_add(nest, -1);
+  if(n == 0)
+  {                                     /* there is no open reservation: all reserved areas are filled */
+    uart_atomic_max(in, *res);
+    if (txx_restart)                    /* If transmit interrupt is disabled, pend the uart interrupt */
+      NVIC->ISPR[(((uint32_t)(int32_t)UARTX_IRQn) >> 5UL)] = (uint32_t)(1UL << (((uint32_t)(int32_t)UARTX_IRQn) & 0x1FUL));
+  }
+  return n;
+}
+#endif
+
+/*------------------------------------------------------------------------------
+  reserve space in the TX buffer
+  - len: number of characters
+  - ts: the reserved area (2 parts if it wraps the end of the buffer)
+  return: 1 = ok (the area must be filled and closed with uartx_txcommit), 0 = not enough free space
+  note: it can be called from the main program and from interrupts at the same time
+ *------------------------------------------------------------------------------*/
+#if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A
+char uartx_txreserve(unsigned int len, struct uart_txspan * ts)
+{
+  unsigned int pos;
+
+  #if UARTX_LAZY_INIT == 1
+  if(!uartx_inited)
     uartx_init();
-    uartx_inited = 1;
+  #endif
+
+  /* first the open reservation counter, so that an interrupting producer does not publish this area */
+  uart_atomic_add(&tbufx.nest, 1);
+  if(!uart_atomic_reserve(&tbufx.res, &tbufx.out, len, TXBUFX_SIZE, &pos))
+  {
+    uartx_txcommit();
+    return 0;
   }
 
-  while(FIFO_TBUFLEN >= TXBUFX_SIZE);
+  #if URGBUFX_SIZE >= 4
+  txx_msgmark(pos, len);
+  #endif
+
+  pos &= TXBUFX_SIZE - 1;
+  ts->p1 = (char *)&tbufx.buf[pos];
+  if(pos + len <= TXBUFX_SIZE)
+  {
+    ts->n1 = len;
+    ts->p2 = (char *)&tbufx.buf[0];
+    ts->n2 = 0;
+  }
+  else
+  {
+    ts->n1 = TXBUFX_SIZE - pos;
+    ts->p2 = (char *)&tbufx.buf[0];
+    ts->n2 = len - ts->n1;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  close the reservation (the last closed reservation publishes all reserved areas to the interrupt)
+ *------------------------------------------------------------------------------*/
+void uartx_txcommit(void)
+{
+  txx_commit(&tbufx.nest, &tbufx.in, &tbufx.res);
+}
+
+/*------------------------------------------------------------------------------
+  transmit a message (the characters of the message are not mixed with other messages)
+  return: number of characters placed in the TX buffer
+  note: if the TX buffer is full, in the main program it will wait until there is free space in it,
+        in interrupt (or if an interrupted producer has an open reservation) it returns without waiting
+ *------------------------------------------------------------------------------*/
+unsigned int uartx_send(const char * buf, unsigned int len)
+{
+  struct uart_txspan ts;
+  unsigned int n, sent = 0;
+
+  while(len)
+  {
+    n = (len > TXBUFX_SIZE) ? TXBUFX_SIZE : len;
+    while(!uartx_txreserve(n, &ts))
+    {
+      if(tbufx.nest || __get_IPSR())
+        return sent;
+    }
+    memcpy(ts.p1, buf, ts.n1);
+    memcpy(ts.p2, buf + ts.n1, ts.n2);
+    uartx_txcommit();
+    buf += n;
+    len -= n;
+    sent += n;
+  }
+  return sent;
+}
 
-  tbufx.buf[tbufx.in & (TXBUFX_SIZE - 1)] = c; /* Add data to the transmit buffer */
-  tbufx.in++;
+/*------------------------------------------------------------------------------
+  transmit a character
+ *------------------------------------------------------------------------------*/
+char uartx_sendchar(char c)
+{
+  struct uart_txspan ts;
 
-  if (txx_restart)
-  {                                     /* If transmit interrupt is disabled, enable it */
-    txx_restart = 0;
-    UARTX->CR1 |= USART_CR1_TXEIE;      /* enable TX interrupt */
+  while(!uartx_txreserve(1, &ts))
+  {
+    if(tbufx.nest || __get_IPSR())
+      return 0;
   }
+  *ts.p1 = c;                           /* Add data to the transmit buffer */
+  uartx_txcommit();
 
   return (0);
 }
 #else
+char uartx_txreserve(unsigned int len, struct uart_txspan * ts) { return 0; }
+void uartx_txcommit(void) { }
+unsigned int uartx_send(const char * buf, unsigned int len) { return 0; }
 char uartx_sendchar(char c) { return 0; }
 #endif
 
+/*------------------------------------------------------------------------------
+  transmit an urgent message (before the characters waiting in the TX buffer)
+  return: number of characters placed in the urgent TX buffer (0 or len)
+  note: if the urgent TX buffer is full, in the main program it will wait until there is free space in it,
+        in interrupt (or if an interrupted producer has an open reservation) it returns without waiting
+ *------------------------------------------------------------------------------*/
+#if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A && URGBUFX_SIZE >= 4
+unsigned int uartx_send_urgent(const char * buf, unsigned int len)
+{
+  unsigned int pos, i;
+
+  if(len > URGBUFX_SIZE)
+    return 0;
+
+  #if UARTX_LAZY_INIT == 1
+  if(!uartx_inited)
+    uartx_init();
+  #endif
+
+  while(1)
+  {
+    uart_atomic_add(&ubufx.nest, 1);
+    if(uart_atomic_reserve(&ubufx.res, &ubufx.out, len, URGBUFX_SIZE, &pos))
+      break;
+    /* a failed reservation can close the last one: it publishes the areas of the interrupted producers */
+    if(txx_commit(&ubufx.nest, &ubufx.in, &ubufx.res) || __get_IPSR())
+      return 0;
+  }
+
+  for(i = 0; i < len; i++)
+    ubufx.buf[(pos + i) & (URGBUFX_SIZE - 1)] = buf[i];
+
+  txx_commit(&ubufx.nest, &ubufx.in, &ubufx.res);
+  return len;
+}
+#else
+unsigned int uartx_send_urgent(const char * buf, unsigned int len) { return 0; }
+#endif
+
 /*------------------------------------------------------------------------------
   initialize the buffers
  *------------------------------------------------------------------------------*/
 void uartx_init(void)
 {
+  #if UARTX_LAZY_INIT == 1
+  uartx_inited = 1;
+  #endif
+
   UARTX_CLOCLK_ON;
 
   #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A
@@ -175,16 +511,43 @@ void uartx_init(void)
   AFIO->MAPR |= 3 < UARTX_MAPR;
   #endif
 
+  #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && UARTX_MUTE == 1
+  #define UARTX_CR1_MUTE         (USART_CR1_WAKE | USART_CR1_M) /* address mark wakeup, 9 bit characters */
+  #elif GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && UARTX_MUTE == 2
+  #define UARTX_CR1_MUTE         (USART_CR1_IDLEIE) /* idle line wakeup */
+  #else
+  #define UARTX_CR1_MUTE         0
+  #endif
+
   /* Enable the USARTx Interrupt */
+  NVIC_SetPriority(UARTX_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), UARTX_PRIORITY, UARTX_SUBPRIORITY));
   NVIC->ISER[(((uint32_t)(int32_t)UARTX_IRQn) >> 5UL)] = (uint32_t)(1UL << (((uint32_t)(int32_t)UARTX_IRQn) & 0x1FUL));
-  NVIC->IP[((uint32_t)(int32_t)UARTX_IRQn)] = (uint8_t)((UART_PRIORITY << (8U - __NVIC_PRIO_BITS)) & (uint32_t)0xFFUL);
 
-  UARTX->CR1 = UARTX_CR1_RXNEIE | UARTX_CR1_TE | UARTX_CR1_RE | USART_CR1_PEIE;
+  UARTX->CR1 = UARTX_CR1_RXNEIE | UARTX_CR1_TE | UARTX_CR1_RE | USART_CR1_PEIE | UARTX_CR1_MUTE;
   UARTX->BRR = UARTX_BRR_CALC;
   UARTX->CR1 |= USART_CR1_UE;
   #undef UARTX_CR1_RXNEIE
   #undef UARTX_CR1_RE
   #undef UARTX_CR1_TE
+  #undef UARTX_CR1_MUTE
+
+  if(UARTX_BRR_CALC < 16 || uartx_bauderr() > UART_BAUD_TOLERANCE || uartx_bauderr() < -UART_BAUD_TOLERANCE)
+    uartx_cbbauderr();                  /* the baud rate is not accurate enough */
+}
+
+/*------------------------------------------------------------------------------
+  actual baud rate and its error (0.01 %)
+ *------------------------------------------------------------------------------*/
+__weak void uartx_cbbauderr(void) { }
+
+unsigned int uartx_baud(void)
+{
+  return UARTX_BAUD_ACT;
+}
+
+int uartx_bauderr(void)
+{
+  return (int)(((long long)UARTX_BAUD_ACT - UARTX_BAUDRATE) * 10000 / UARTX_BAUDRATE);
 }
 
 /*------------------------------------------------------------------------------
@@ -194,37 +557,66 @@ void uartx_init(void)
 int _write (int fd, char *ptr, int len)
 {
   int i = 0;
-  while (*ptr && (i < len))
-  {
-    uartx_sendchar(*ptr);
+  while ((i < len) && ptr[i])
     i++;
-    ptr++;
-  }
-  return i;
+  return uartx_send(ptr, i);  /* one message (not mixed with the other producers) */
 }
 #endif
 
 #undef  UARTX
 #undef  UARTX_IRQHandler
 #undef  UARTX_IRQn
+#undef  UARTX_PRIORITY
+#undef  UARTX_SUBPRIORITY
 #undef  UARTX_CLOCLK_ON
+#undef  UARTX_CLK
 #undef  UARTX_BRR_CALC
+#undef  UARTX_BAUD_ACT
 #undef  UARTX_RX
 #undef  UARTX_TX
 #undef  UARTX_REMAP
 #undef  UARTX_MAPR
 #undef  TXBUFX_SIZE
+#undef  URGBUFX_SIZE
 #undef  RXBUFX_SIZE
 #undef  UARTX_PRINTF
+#undef  UARTX_LAZY_INIT
+#undef  UARTX_RXHOOK
+#undef  UARTX_MUTE
+#undef  UARTX_BAUDRATE
 #undef  UART_IO_SETMODE
 #undef  uartx_inited
 #undef  txx_restart
+#undef  rxx_addr
+#undef  rxx_mutereq
+#undef  rxx_first
+#undef  rtox_cycles
+#undef  rtox_last
+#undef  rtox_armed
+#undef  txx_urgent
+#undef  txx_inmsg
+#undef  txx_msgmark
+#undef  txx_commit
 #undef  bufx_r
 #undef  bufx_t
+#undef  bufx_u
 #undef  rbufx
 #undef  tbufx
+#undef  ubufx
 #undef  uartx_init
 #undef  uartx_sendchar
+#undef  uartx_send
+#undef  uartx_send_urgent
+#undef  uartx_txreserve
+#undef  uartx_txcommit
 #undef  uartx_getchar
 #undef  uartx_cbrx
 #undef  uartx_cbrxof
+#undef  uartx_rxhook
+#undef  uartx_rtoset
+#undef  uartx_rtopoll
+#undef  uartx_cbrto
+#undef  uartx_mute
+#undef  uartx_baud
+#undef  uartx_bauderr
+#undef  uartx_cbbauderr
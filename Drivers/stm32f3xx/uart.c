@@ -4,6 +4,7 @@
 */
 
 #include <stdio.h>
+#include <string.h>
 #include "main.h"
 #include "uart.h"
 
@@ -90,128 +91,471 @@
 #define GPIOX_PORTNAME_(a,b,c) a
 #define GPIOX_PORTNAME(a)     GPIOX_PORTNAME_(a)
 
+//----------------------------------------------------------------------------
+/* RX DMA (UARTx_RXDMA: DMA number, channel number) */
+#define DMAX_NUM_(a,b)        a
+#define DMAX_NUM(a)           DMAX_NUM_(a)
+
+#define DMAX_CH_(a,b)         DMA ## a ## _Channel ## b
+#define DMAX_CH(a)            DMAX_CH_(a)
+
+#define DMAX_CLOCK_(a,b)      RCC_AHBENR_DMA ## a ## EN
+#define DMAX_CLOCK(a)         DMAX_CLOCK_(a)
+
+#define DMAX_NDTR_(a,b)       DMA ## a ## _Channel ## b->CNDTR
+#define DMAX_NDTR(a)          DMAX_NDTR_(a)
+
+//----------------------------------------------------------------------------
+/* Atomic operations for the multiple producer TX buffer (Cortex-M3/M4/M7: LDREX/STREX) */
+
+/* *p += a, return: the new value */
+static inline unsigned int uart_atomic_add(volatile unsigned int * p, int a)
+{
+  unsigned int r;
+  do
+    r = __LDREXW((volatile uint32_t *)p) + a;
+  while(__STREXW(r, (volatile uint32_t *)p));
+  return r;
+}
+
+/* *p = v, if v is after *p (the indexes are running, overflow is allowed) */
+static inline void uart_atomic_max(volatile unsigned int * p, unsigned int v)
+{
+  do
+  {
+    if((int)(v - __LDREXW((volatile uint32_t *)p)) <= 0)
+    {
+      __CLREX();
+      return;
+    }
+  } while(__STREXW(v, (volatile uint32_t *)p));
+}
+
+/* *pos = *res, *res += len if there is enough free space (size - (*res - *out))
+   return: 1 = ok, 0 = not enough free space */
+static inline char uart_atomic_reserve(volatile unsigned int * res, volatile unsigned int * out, unsigned int len, unsigned int size, unsigned int * pos)
+{
+  unsigned int r;
+  do
+  {
+    r = __LDREXW((volatile uint32_t *)res);
+    if(r + len - *out > size)
+    {
+      __CLREX();
+      return 0;
+    }
+  } while(__STREXW(r + len, (volatile uint32_t *)res));
+  *pos = r;
+  return 1;
+}
+
+/* *p = (*p & ~clr) | set */
+static inline void uart_atomic_bits(volatile unsigned int * p, unsigned int clr, unsigned int set)
+{
+  while(__STREXW((__LDREXW((volatile uint32_t *)p) & ~clr) | set, (volatile uint32_t *)p));
+}
+
 //----------------------------------------------------------------------------
 #if UART1_BAUDRATE > 0 && (GPIOX_PORTNUM(UART1_RX) >= GPIOX_PORTNUM_A && RXBUF1_SIZE >= 4 || GPIOX_PORTNUM(UART1_TX) >= GPIOX_PORTNUM_A && TXBUF1_SIZE >= 4)
+#define UA1
 #define UARTX                 USART1
 #define UARTX_IRQHandler      USART1_IRQHandler
 #define UARTX_IRQn            USART1_IRQn
+#define UARTX_PRIORITY        UART1_PRIORITY
+#define UARTX_SUBPRIORITY     UART1_SUBPRIORITY
 #define UARTX_CLOCLK_ON       RCC->APB2ENR |= RCC_APB2ENR_USART1EN
-#define UARTX_BRR_CALC        (UART_1_CLK) / UART1_BAUDRATE
+#define UARTX_CLK             (UART_1_CLK)
 #define UARTX_RX              UART1_RX
 #define UARTX_TX              UART1_TX
 #define TXBUFX_SIZE           TXBUF1_SIZE
+#define URGBUFX_SIZE          URGBUF1_SIZE
 #define RXBUFX_SIZE           RXBUF1_SIZE
 #define UARTX_PRINTF          UART1_PRINTF
+#define UARTX_LAZY_INIT       UART1_LAZY_INIT
+#define UARTX_RXHOOK          UART1_RXHOOK
+#define UARTX_MUTE            UART1_MUTE
+#define UARTX_OVER8           UART1_OVER8
+#define UARTX_RXDMA           UART1_RXDMA
+#define UARTX_RXMATCH         UART1_RXMATCH
+#define UARTX_BAUDRATE        UART1_BAUDRATE
 #define uartx_inited          uart1_inited
 #define txx_restart           tx1_restart
+#define rxx_addr              rx1_addr
+#define rxx_mutereq           rx1_mutereq
+#define rxx_first             rx1_first
+#define rxx_mark              rx1_mark
+#define rxx_dmasync           rx1_dmasync
+#define rxx_dmaovr            rx1_dmaovr
+#define txx_urgent            tx1_urgent
+#define txx_inmsg             tx1_inmsg
+#define txx_msgmark           tx1_msgmark
+#define txx_commit            tx1_commit
 #define bufx_r                buf1_r
 #define bufx_t                buf1_t
+#define bufx_u                buf1_u
 #define rbufx                 rbuf1
 #define tbufx                 tbuf1
+#define ubufx                 ubuf1
 #define uartx_init            uart1_init
 #define uartx_sendchar        uart1_sendchar
+#define uartx_send            uart1_send
+#define uartx_send_urgent     uart1_send_urgent
+#define uartx_txreserve       uart1_txreserve
+#define uartx_txcommit        uart1_txcommit
 #define uartx_getchar         uart1_getchar
 #define uartx_cbrx            uart1_cbrx
 #define uartx_cbrxof          uart1_cbrxof
+#define uartx_rxhook          uart1_rxhook
+#define uartx_rtoset          uart1_rtoset
+#define uartx_rtopoll         uart1_rtopoll
+#define uartx_cbrto           uart1_cbrto
+#define uartx_mute            uart1_mute
+#define uartx_baud            uart1_baud
+#define uartx_bauderr         uart1_bauderr
+#define uartx_cbbauderr       uart1_cbbauderr
+#define uartx_getline         uart1_getline
+#define uartx_cbrxline        uart1_cbrxline
 #include "uartx.h"
 #endif
 
 #if UART2_BAUDRATE > 0 && (GPIOX_PORTNUM(UART2_RX) >= GPIOX_PORTNUM_A && RXBUF2_SIZE >= 4 || GPIOX_PORTNUM(UART2_TX) >= GPIOX_PORTNUM_A && TXBUF2_SIZE >= 4)
+#define UA2
 #define UARTX                 USART2
 #define UARTX_IRQHandler      USART2_IRQHandler
 #define UARTX_IRQn            USART2_IRQn
+#define UARTX_PRIORITY        UART2_PRIORITY
+#define UARTX_SUBPRIORITY     UART2_SUBPRIORITY
 #define UARTX_CLOCLK_ON       RCC->APB1ENR |= RCC_APB1ENR_USART2EN
-#define UARTX_BRR_CALC        (UART_2_CLK) / UART2_BAUDRATE
+#define UARTX_CLK             (UART_2_CLK)
 #define UARTX_RX              UART2_RX
 #define UARTX_TX              UART2_TX
 #define TXBUFX_SIZE           TXBUF2_SIZE
+#define URGBUFX_SIZE          URGBUF2_SIZE
 #define RXBUFX_SIZE           RXBUF2_SIZE
 #define UARTX_PRINTF          UART2_PRINTF
+#define UARTX_LAZY_INIT       UART2_LAZY_INIT
+#define UARTX_RXHOOK          UART2_RXHOOK
+#define UARTX_MUTE            UART2_MUTE
+#define UARTX_OVER8           UART2_OVER8
+#define UARTX_RXDMA           UART2_RXDMA
+#define UARTX_RXMATCH         UART2_RXMATCH
+#define UARTX_BAUDRATE        UART2_BAUDRATE
 #define uartx_inited          uart2_inited
 #define txx_restart           tx2_restart
+#define rxx_addr              rx2_addr
+#define rxx_mutereq           rx2_mutereq
+#define rxx_first             rx2_first
+#define rxx_mark              rx2_mark
+#define rxx_dmasync           rx2_dmasync
+#define rxx_dmaovr            rx2_dmaovr
+#define txx_urgent            tx2_urgent
+#define txx_inmsg             tx2_inmsg
+#define txx_msgmark           tx2_msgmark
+#define txx_commit            tx2_commit
 #define bufx_r                buf2_r
 #define bufx_t                buf2_t
+#define bufx_u                buf2_u
 #define rbufx                 rbuf2
 #define tbufx                 tbuf2
+#define ubufx                 ubuf2
 #define uartx_init            uart2_init
 #define uartx_sendchar        uart2_sendchar
+#define uartx_send            uart2_send
+#define uartx_send_urgent     uart2_send_urgent
+#define uartx_txreserve       uart2_txreserve
+#define uartx_txcommit        uart2_txcommit
 #define uartx_getchar         uart2_getchar
 #define uartx_cbrx            uart2_cbrx
 #define uartx_cbrxof          uart2_cbrxof
+#define uartx_rxhook          uart2_rxhook
+#define uartx_rtoset          uart2_rtoset
+#define uartx_rtopoll         uart2_rtopoll
+#define uartx_cbrto           uart2_cbrto
+#define uartx_mute            uart2_mute
+#define uartx_baud            uart2_baud
+#define uartx_bauderr         uart2_bauderr
+#define uartx_cbbauderr       uart2_cbbauderr
+#define uartx_getline         uart2_getline
+#define uartx_cbrxline        uart2_cbrxline
 #include "uartx.h"
 #endif
 
 #if UART3_BAUDRATE > 0 && (GPIOX_PORTNUM(UART3_RX) >= GPIOX_PORTNUM_A && RXBUF3_SIZE >= 4 || GPIOX_PORTNUM(UART3_TX) >= GPIOX_PORTNUM_A && TXBUF3_SIZE >= 4)
+#define UA3
 #define UARTX                 USART3
 #define UARTX_IRQHandler      USART3_IRQHandler
 #define UARTX_IRQn            USART3_IRQn
+#define UARTX_PRIORITY        UART3_PRIORITY
+#define UARTX_SUBPRIORITY     UART3_SUBPRIORITY
 #define UARTX_CLOCLK_ON       RCC->APB1ENR |= RCC_APB1ENR_USART3EN
-#define UARTX_BRR_CALC        (UART_3_CLK) / UART3_BAUDRATE
+#define UARTX_CLK             (UART_3_CLK)
 #define UARTX_RX              UART3_RX
 #define UARTX_TX              UART3_TX
 #define TXBUFX_SIZE           TXBUF3_SIZE
+#define URGBUFX_SIZE          URGBUF3_SIZE
 #define RXBUFX_SIZE           RXBUF3_SIZE
 #define UARTX_PRINTF          UART3_PRINTF
+#define UARTX_LAZY_INIT       UART3_LAZY_INIT
+#define UARTX_RXHOOK          UART3_RXHOOK
+#define UARTX_MUTE            UART3_MUTE
+#define UARTX_OVER8           UART3_OVER8
+#define UARTX_RXDMA           UART3_RXDMA
+#define UARTX_RXMATCH         UART3_RXMATCH
+#define UARTX_BAUDRATE        UART3_BAUDRATE
 #define uartx_inited          uart3_inited
 #define txx_restart           tx3_restart
+#define rxx_addr              rx3_addr
+#define rxx_mutereq           rx3_mutereq
+#define rxx_first             rx3_first
+#define rxx_mark              rx3_mark
+#define rxx_dmasync           rx3_dmasync
+#define rxx_dmaovr            rx3_dmaovr
+#define txx_urgent            tx3_urgent
+#define txx_inmsg             tx3_inmsg
+#define txx_msgmark           tx3_msgmark
+#define txx_commit            tx3_commit
 #define bufx_r                buf3_r
 #define bufx_t                buf3_t
+#define bufx_u                buf3_u
 #define rbufx                 rbuf3
 #define tbufx                 tbuf3
+#define ubufx                 ubuf3
 #define uartx_init            uart3_init
 #define uartx_sendchar        uart3_sendchar
+#define uartx_send            uart3_send
+#define uartx_send_urgent     uart3_send_urgent
+#define uartx_txreserve       uart3_txreserve
+#define uartx_txcommit        uart3_txcommit
 #define uartx_getchar         uart3_getchar
 #define uartx_cbrx            uart3_cbrx
 #define uartx_cbrxof          uart3_cbrxof
+#define uartx_rxhook          uart3_rxhook
+#define uartx_rtoset          uart3_rtoset
+#define uartx_rtopoll         uart3_rtopoll
+#define uartx_cbrto           uart3_cbrto
+#define uartx_mute            uart3_mute
+#define uartx_baud            uart3_baud
+#define uartx_bauderr         uart3_bauderr
+#define uartx_cbbauderr       uart3_cbbauderr
+#define uartx_getline         uart3_getline
+#define uartx_cbrxline        uart3_cbrxline
 #include "uartx.h"
 #endif
 
 #if UART4_BAUDRATE > 0 && (GPIOX_PORTNUM(UART4_RX) >= GPIOX_PORTNUM_A && RXBUF4_SIZE >= 4 || GPIOX_PORTNUM(UART4_TX) >= GPIOX_PORTNUM_A && TXBUF4_SIZE >= 4)
+#define UA4
 #define UARTX                 UART4
 #define UARTX_IRQHandler      UART4_IRQHandler
 #define UARTX_IRQn            UART4_IRQn
+#define UARTX_PRIORITY        UART4_PRIORITY
+#define UARTX_SUBPRIORITY     UART4_SUBPRIORITY
 #define UARTX_CLOCLK_ON       RCC->APB1ENR |= RCC_APB1ENR_UART4EN
-#define UARTX_BRR_CALC        (UART_4_5_CLK) / UART4_BAUDRATE
+#define UARTX_CLK             (UART_4_5_CLK)
 #define UARTX_RX              UART4_RX
 #define UARTX_TX              UART4_TX
 #define TXBUFX_SIZE           TXBUF4_SIZE
+#define URGBUFX_SIZE          URGBUF4_SIZE
 #define RXBUFX_SIZE           RXBUF4_SIZE
 #define UARTX_PRINTF          UART4_PRINTF
+#define UARTX_LAZY_INIT       UART4_LAZY_INIT
+#define UARTX_RXHOOK          UART4_RXHOOK
+#define UARTX_MUTE            UART4_MUTE
+#define UARTX_OVER8           UART4_OVER8
+#define UARTX_RXDMA           UART4_RXDMA
+#define UARTX_RXMATCH         UART4_RXMATCH
+#define UARTX_BAUDRATE        UART4_BAUDRATE
 #define uartx_inited          uart4_inited
 #define txx_restart           tx4_restart
+#define rxx_addr              rx4_addr
+#define rxx_mutereq           rx4_mutereq
+#define rxx_first             rx4_first
+#define rxx_mark              rx4_mark
+#define rxx_dmasync           rx4_dmasync
+#define rxx_dmaovr            rx4_dmaovr
+#define txx_urgent            tx4_urgent
+#define txx_inmsg             tx4_inmsg
+#define txx_msgmark           tx4_msgmark
+#define txx_commit            tx4_commit
 #define bufx_r                buf4_r
 #define bufx_t                buf4_t
+#define bufx_u                buf4_u
 #define rbufx                 rbuf4
 #define tbufx                 tbuf4
+#define ubufx                 ubuf4
 #define uartx_init            uart4_init
 #define uartx_sendchar        uart4_sendchar
+#define uartx_send            uart4_send
+#define uartx_send_urgent     uart4_send_urgent
+#define uartx_txreserve       uart4_txreserve
+#define uartx_txcommit        uart4_txcommit
 #define uartx_getchar         uart4_getchar
 #define uartx_cbrx            uart4_cbrx
 #define uartx_cbrxof          uart4_cbrxof
+#define uartx_rxhook          uart4_rxhook
+#define uartx_rtoset          uart4_rtoset
+#define uartx_rtopoll         uart4_rtopoll
+#define uartx_cbrto           uart4_cbrto
+#define uartx_mute            uart4_mute
+#define uartx_baud            uart4_baud
+#define uartx_bauderr         uart4_bauderr
+#define uartx_cbbauderr       uart4_cbbauderr
+#define uartx_getline         uart4_getline
+#define uartx_cbrxline        uart4_cbrxline
 #include "uartx.h"
 #endif
 
 #if UART5_BAUDRATE > 0 && (GPIOX_PORTNUM(UART5_RX) >= GPIOX_PORTNUM_A && RXBUF5_SIZE >= 4 || GPIOX_PORTNUM(UART5_TX) >= GPIOX_PORTNUM_A && TXBUF5_SIZE >= 4)
+#define UA5
 #define UARTX                 UART5
 #define UARTX_IRQHandler      UART5_IRQHandler
 #define UARTX_IRQn            UART5_IRQn
+#define UARTX_PRIORITY        UART5_PRIORITY
+#define UARTX_SUBPRIORITY     UART5_SUBPRIORITY
 #define UARTX_CLOCLK_ON       RCC->APB1ENR |= RCC_APB1ENR_UART5EN
-#define UARTX_BRR_CALC        (UART_4_5_CLK) / UART5_BAUDRATE
+#define UARTX_CLK             (UART_4_5_CLK)
 #define UARTX_RX              UART5_RX
 #define UARTX_TX              UART5_TX
 #define TXBUFX_SIZE           TXBUF5_SIZE
+#define URGBUFX_SIZE          URGBUF5_SIZE
 #define RXBUFX_SIZE           RXBUF5_SIZE
 #define UARTX_PRINTF          UART5_PRINTF
+#define UARTX_LAZY_INIT       UART5_LAZY_INIT
+#define UARTX_RXHOOK          UART5_RXHOOK
+#define UARTX_MUTE            UART5_MUTE
+#define UARTX_OVER8           UART5_OVER8
+#define UARTX_RXDMA           UART5_RXDMA
+#define UARTX_RXMATCH         UART5_RXMATCH
+#define UARTX_BAUDRATE        UART5_BAUDRATE
 #define uartx_inited          uart5_inited
 #define txx_restart           tx5_restart
+#define rxx_addr              rx5_addr
+#define rxx_mutereq           rx5_mutereq
+#define rxx_first             rx5_first
+#define rxx_mark              rx5_mark
+#define rxx_dmasync           rx5_dmasync
+#define rxx_dmaovr            rx5_dmaovr
+#define txx_urgent            tx5_urgent
+#define txx_inmsg             tx5_inmsg
+#define txx_msgmark           tx5_msgmark
+#define txx_commit            tx5_commit
 #define bufx_r                buf5_r
 #define bufx_t                buf5_t
+#define bufx_u                buf5_u
 #define rbufx                 rbuf5
 #define tbufx                 tbuf5
+#define ubufx                 ubuf5
 #define uartx_init            uart5_init
 #define uartx_sendchar        uart5_sendchar
+#define uartx_send            uart5_send
+#define uartx_send_urgent     uart5_send_urgent
+#define uartx_txreserve       uart5_txreserve
+#define uartx_txcommit        uart5_txcommit
 #define uartx_getchar         uart5_getchar
 #define uartx_cbrx            uart5_cbrx
 #define uartx_cbrxof          uart5_cbrxof
+#define uartx_rxhook          uart5_rxhook
+#define uartx_rtoset          uart5_rtoset
+#define uartx_rtopoll         uart5_rtopoll
+#define uartx_cbrto           uart5_cbrto
+#define uartx_mute            uart5_mute
+#define uartx_baud            uart5_baud
+#define uartx_bauderr         uart5_bauderr
+#define uartx_cbbauderr       uart5_cbbauderr
+#define uartx_getline         uart5_getline
+#define uartx_cbrxline        uart5_cbrxline
 #include "uartx.h"
 #endif
+
+/*------------------------------------------------------------------------------
+  initialize all used uarts
+ *------------------------------------------------------------------------------*/
+#if UART_INIT_CONSTRUCTOR == 1
+__attribute__((constructor))
+#endif
+void uart_init_all(void)
+{
+  #ifdef UA1
+  uart1_init();
+  #endif
+  #ifdef UA2
+  uart2_init();
+  #endif
+  #ifdef UA3
+  uart3_init();
+  #endif
+  #ifdef UA4
+  uart4_init();
+  #endif
+  #ifdef UA5
+  uart5_init();
+  #endif
+}
+
+/*------------------------------------------------------------------------------
+  print the interrupt priority of the used uarts in preemption order (printf)
+ *------------------------------------------------------------------------------*/
+void uart_priority_report(void)
+{
+  static const struct { unsigned char num; IRQn_Type irqn; } uirq[] = {
+    #ifdef UA1
+    { 1, USART1_IRQn },
+    #endif
+    #ifdef UA2
+    { 2, USART2_IRQn },
+    #endif
+    #ifdef UA3
+    { 3, USART3_IRQn },
+    #endif
+    #ifdef UA4
+    { 4, UART4_IRQn },
+    #endif
+    #ifdef UA5
+    { 5, UART5_IRQn },
+    #endif
+    { 0, (IRQn_Type)0 } };
+  uint32_t grp = NVIC_GetPriorityGrouping(), pre, sub, p, i;
+
+  printf("uart interrupt priorities (preemption order, priority grouping %u):\r\n", (unsigned int)grp);
+  for(p = 0; p < (1UL << __NVIC_PRIO_BITS); p++)
+    for(i = 0; uirq[i].num; i++)
+    {
+      NVIC_DecodePriority(NVIC_GetPriority(uirq[i].irqn), grp, &pre, &sub);
+      if(pre == p)
+        printf("  UART%u: preemption priority %u, sub priority %u\r\n", (unsigned int)uirq[i].num, (unsigned int)pre, (unsigned int)sub);
+    }
+}
+
+/*------------------------------------------------------------------------------
+  print the baud rate, the actual baud rate and the error of the used uarts (printf)
+ *------------------------------------------------------------------------------*/
+void uart_baud_report(void)
+{
+  static const struct { unsigned char num; unsigned int baud; unsigned int (*act)(void); int (*err)(void); } ubaud[] = {
+    #ifdef UA1
+    { 1, UART1_BAUDRATE, uart1_baud, uart1_bauderr },
+    #endif
+    #ifdef UA2
+    { 2, UART2_BAUDRATE, uart2_baud, uart2_bauderr },
+    #endif
+    #ifdef UA3
+    { 3, UART3_BAUDRATE, uart3_baud, uart3_bauderr },
+    #endif
+    #ifdef UA4
+    { 4, UART4_BAUDRATE, uart4_baud, uart4_bauderr },
+    #endif
+    #ifdef UA5
+    { 5, UART5_BAUDRATE, uart5_baud, uart5_bauderr },
+    #endif
+    { 0, 0, 0, 0 } };
+  unsigned int i, e;
+  int err;
+
+  printf("uart baud rates (tolerance %u.%02u %%):\r\n", UART_BAUD_TOLERANCE / 100, UART_BAUD_TOLERANCE % 100);
+  for(i = 0; ubaud[i].num; i++)
+  {
+    err = ubaud[i].err();
+    e = (err < 0) ? -err : err;
+    printf("  UART%u: %u baud, actual %u baud, error %c%u.%02u %%%s\r\n", (unsigned int)ubaud[i].num, ubaud[i].baud,
+           ubaud[i].act(), (err < 0) ? '-' : '+', e / 100, e % 100, (e > UART_BAUD_TOLERANCE) ? " (too large)" : "");
+  }
+}
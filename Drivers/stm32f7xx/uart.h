@@ -13,11 +13,17 @@ extern "C" {
    This driver also uses an interrupt and an adjustable buffer for sending and receiving.
    When receiving, it is possible to use a callback function for each character received.
    Thus, it is possible e.g. to detect the end of line character.
-   Initialization will occur during the first use, so there is no uart_init function.
+   Initialization will occur during the first use (UARTx_LAZY_INIT = 1),
+   or it can be done in advance with the uart_init_all or uartx_init function.
 
    For settings note:
+   - UART_INIT_CONSTRUCTOR: 1 -> uart_init_all is called automatically before main
+       note: the baud rate is calculated from SystemCoreClock, it must be valid at this time
+             (if the clock is set in main, leave 0 and call uart_init_all after the clock setting)
+
    - UART_PRIORITY: UART RX and TX interrupt priority (0..15)
        note: 0 = the highest priority, 15 = the lowest priority
+             this is the default value of UARTx_PRIORITY
 
    - UART_1_CLK...UART_8_CLK: USART1...USART8 source frequency
        note: default (SystemCoreClock >> 1 and SystemCoreClock >> 2)
@@ -25,17 +31,84 @@ extern "C" {
    - UARTx_BAUDRATE: Baud rate (bit/sec)
        note: if Baud Rate = 0 -> this uart not used
 
+   - UART_BAUD_TOLERANCE: max baud rate error in 0.01 % (the divider is rounded to the nearest)
+       note: if the uart clock is a constant -> compile time error, otherwise uartx_cbbauderr is called
+             in uartx_init
+
    - UARTx_RX, UARTx_TX: port name, pin number, AF number (if not used -> X, 0, 0)
        note: this possible port name, pin number, AF number (see the processor datasheet)
 
    - TXBUFx_SIZE, RXBUFx_SIZE: buffer size (4,8,16,32,64,128,256,512,1024,2048,...)
        note: the buffer size should be (2 ^ n) !
 
+   - URGBUFx_SIZE: urgent TX buffer size (0 = not used, 4,8,16,32,64,...)
+       note: the urgent messages are sent before the characters waiting in the TX buffer,
+             but only at a message boundary of the TX buffer (a message: one uartx_sendchar, uartx_send
+             or uartx_txreserve call), so the response time does not depend on the TX buffer content
+
    - UARTx_PRINTF (printf redirect): 0 -> printf to uart disabled, 1 -> printf to uart eanbled
        note: can only be active on one usart
 
+   - UARTx_PRIORITY, UARTx_SUBPRIORITY: interrupt preemption priority and sub priority of this uart
+       note: the number of preemption and sub priority bits depends on the priority grouping
+             (NVIC_SetPriorityGrouping, it must be set before the initialization)
+             a uart with a higher preemption priority (lower number) can interrupt the others
+
+   - UARTx_RXDMA: RX with DMA: DMA number, stream number, channel number (0, 0, 0 = RX with interrupt)
+       note: USART1: (2, 2, 4) (2, 5, 4), USART2: (1, 5, 4), USART3: (1, 1, 4), UART4: (1, 2, 4)
+             UART5: (1, 0, 4), USART6: (2, 1, 5) (2, 2, 5), UART7: (1, 3, 5), UART8: (1, 6, 5)
+             if the data cache is enabled, the RX buffer is invalidated before reading
+             with DMA there is no interrupt for every character, the interrupt is only at the
+             UARTx_RXMATCH character (character match) and at the idle line
+             the DMA writes the RX buffer circularly, if it is not read in time, the old data is overwritten
+             (the next read calls uartx_cbrxof and drops the unread characters)
+             the characters do not go through the interrupt: uartx_cbrx is not called and
+             UARTx_RXHOOK can not be used (the protocol layers fed from uartx_rxhook need RX with interrupt)
+
+   - UARTx_RXMATCH: end of line character for the character match (with UARTx_RXDMA)
+
+   - UARTx_MUTE: mute mode for multi-drop (e.g. RS-485) buses: 0 = not used
+                 1 = address mark wakeup (9 bit characters, the 9th bit marks the address character)
+                 2 = idle line wakeup (the first character after the idle line is the address)
+       note: in mute mode the frames of the other nodes are discarded by the hardware (no interrupt)
+             the address characters are not stored in the RX buffer
+             it can not be used with UARTx_RXDMA (the address mark wakeup uses the ADD field in CR2)
+             UARTx_MUTE = 1: a new address is written at the end of the current transmission (TC interrupt)
+
+   - UARTx_OVER8: oversampling: 0 = 16x, 1 = 8x, 2 = automatic (8x only if the baud rate can not be
+                  reached with 16x: clock / baud rate < 16)
+       note: with 8x oversampling the max baud rate is clock / 8, but the receiver is less tolerant
+             of the clock deviation and the noise
+
+   - UARTx_RXHOOK: 1 -> the received characters are given to uartx_rxhook (in the interrupt, not with UARTx_RXDMA)
+
+   - UARTx_LAZY_INIT: 1 -> initialization on the first uartx_sendchar or uartx_getchar call
+                      0 -> uart_init_all or uartx_init must be called before use
+       note: with 0 there is no initialization check in uartx_sendchar and uartx_getchar
+
+   - uart_init_all: initialize all used uarts
+
+   - uartx_init: initialize one uart
+
+   - uart_priority_report: print the uart interrupt priorities in preemption order (with printf)
+
+   - uart_baud_report: print the baud rates, the actual baud rates and the errors of the used uarts (with printf)
+
    - uartx_sendchar: send one character to usart
-       note: if the TX buffer is full, it will wait until there is free space in it
+       note: if the TX buffer is full, it will wait until there is free space in it (in interrupt it does not wait)
+
+   - uartx_send: send a message to usart (the characters of the message are not mixed with other messages)
+       note: it can be called from the main program and from interrupts at the same time
+             if the TX buffer is full, it will wait until there is free space in it (in interrupt it does not wait)
+             return = number of characters placed in the TX buffer
+
+   - uartx_send_urgent: send an urgent message to usart (with URGBUFx_SIZE >= 4)
+       note: the whole message is sent without interruption, before the waiting normal messages
+             return = number of characters placed in the urgent TX buffer (0 or len)
+
+   - uartx_txreserve, uartx_txcommit: write directly to the TX buffer
+       note: if return = 0 -> there is not enough free space
+             if return = 1 -> the area in ts is reserved, fill it (e.g. with UART_TXSPAN_PUT) and call uartx_txcommit
 
    - uartx_getchar: receiving a character on uart rx
        note: if return = 0 -> no characters received (not block the program from running)
@@ -47,10 +120,54 @@ extern "C" {
    - uartx_cbrxof: if you want to know that an RX buffer is overflowed, do a function with that name
        note: if this function is enabled, RX data loss has occurred
              attention, it will be operated from an interruption!
+
+   - uartx_rtoset: receiver timeout after the last received character (bits: in bit time, 0 = off)
+       note: when it expires, uartx_cbrto is called (e.g. end of a Modbus RTU frame)
+             hardware receiver timeout (RTOR), if the usart does not support it, uartx_cbrto is never called
+
+   - uartx_cbrto: if you want to know that the receiver timeout is expired, do a function with that name
+       note: attention, it will be operated from an interruption!
+
+   - uartx_getline: receiving a line (with UARTx_RXDMA, to the UARTx_RXMATCH character or to an idle line)
+       note: if return = 0 -> there is no complete line
+             if return > 0 -> length of the line in buf (if the line is longer than size, the rest is the next line)
+
+   - uartx_cbrxline: if you want to know that a line has arrived (with UARTx_RXDMA), do a function with that name
+       note: attention, it will be operated from an interruption!
+
+   - uartx_mute: set the node address and enter the mute mode (with UARTx_MUTE > 0)
+       note: the usart receives only the frames with this address
+
+   - uartx_baud: actual baud rate (uart clock / divider)
+
+   - uartx_bauderr: baud rate error in 0.01 % (e.g. -35 = -0.35 %)
+
+   - uartx_cbbauderr: if you want to know that the baud rate error is larger than UART_BAUD_TOLERANCE
+                      (or the divider is too small), do a function with that name
+       note: it is called from uartx_init
+
+   - uartx_rxhook: receive hook (with UARTx_RXHOOK = 1 this function must be made)
+       note: every received character is given to it (err = 1: noise, framing or overrun error)
+             if return = 1 -> the character is processed (e.g. by a protocol layer, see Drivers/protocol)
+             if return = 0 -> the character goes into the RX buffer
+             attention, it will be operated from an interruption!
 */
 
 //----------------------------------------------------------------------------
 #define  UART_PRIORITY   15
+#define  UART_INIT_CONSTRUCTOR  0
+#define  UART_BAUD_TOLERANCE    200
+
+/* reserved area in the TX buffer (see uartx_txreserve) */
+struct uart_txspan {
+  char * p1;                            /* first part */
+  unsigned int n1;                      /* length of the first part */
+  char * p2;                            /* second part (from the beginning of the buffer) */
+  unsigned int n2;                      /* length of the second part */
+};
+
+/* write one character to the reserved area */
+#define  UART_TXSPAN_PUT(ts, c) { if((ts)->n1) { *(ts)->p1++ = (c); (ts)->n1--; } else { *(ts)->p2++ = (c); (ts)->n2--; } }
 
 //----------------------------------------------------------------------------
 #define  UART_1_CLK       SystemCoreClock >> 1
@@ -59,12 +176,36 @@ extern "C" {
 #define  UART1_TX   A, 9, 7
 #define  RXBUF1_SIZE  64
 #define  TXBUF1_SIZE  64
+#define  URGBUF1_SIZE  0
 #define  UART1_PRINTF  0
-
+#define  UART1_LAZY_INIT  1
+#define  UART1_PRIORITY  UART_PRIORITY
+#define  UART1_SUBPRIORITY  0
+#define  UART1_RXHOOK  0
+#define  UART1_MUTE  0
+#define  UART1_OVER8  2
+#define  UART1_RXDMA  0, 0, 0
+#define  UART1_RXMATCH  '\n'
+
+void     uart1_init(void);
 char     uart1_sendchar(char c);
+unsigned int uart1_send(const char * buf, unsigned int len);
+char     uart1_txreserve(unsigned int len, struct uart_txspan * ts);
+void     uart1_txcommit(void);
+unsigned int uart1_send_urgent(const char * buf, unsigned int len);
 char     uart1_getchar(char * c);
 __weak void uart1_cbrx(char rxch);
 __weak void uart1_cbrxof(void);
+char     uart1_rxhook(char rxch, char err);
+void     uart1_rtoset(unsigned int bits);
+void     uart1_rtopoll(void);
+__weak void uart1_cbrto(void);
+void     uart1_mute(unsigned char addr);
+unsigned int uart1_baud(void);
+int      uart1_bauderr(void);
+__weak void uart1_cbbauderr(void);
+unsigned int uart1_getline(char * buf, unsigned int size);
+__weak void uart1_cbrxline(void);
 
 //----------------------------------------------------------------------------
 #define  UART_2_CLK       SystemCoreClock >> 2
@@ -73,12 +214,36 @@ __weak void uart1_cbrxof(void);
 #define  UART2_TX   A, 2, 7
 #define  RXBUF2_SIZE  64
 #define  TXBUF2_SIZE  64
+#define  URGBUF2_SIZE  0
 #define  UART2_PRINTF  0
-
+#define  UART2_LAZY_INIT  1
+#define  UART2_PRIORITY  UART_PRIORITY
+#define  UART2_SUBPRIORITY  0
+#define  UART2_RXHOOK  0
+#define  UART2_MUTE  0
+#define  UART2_OVER8  2
+#define  UART2_RXDMA  0, 0, 0
+#define  UART2_RXMATCH  '\n'
+
+void     uart2_init(void);
 char     uart2_sendchar(char c);
+unsigned int uart2_send(const char * buf, unsigned int len);
+char     uart2_txreserve(unsigned int len, struct uart_txspan * ts);
+void     uart2_txcommit(void);
+unsigned int uart2_send_urgent(const char * buf, unsigned int len);
 char     uart2_getchar(char * c);
 __weak void uart2_cbrx(char rxch);
 __weak void uart2_cbrxof(void);
+char     uart2_rxhook(char rxch, char err);
+void     uart2_rtoset(unsigned int bits);
+void     uart2_rtopoll(void);
+__weak void uart2_cbrto(void);
+void     uart2_mute(unsigned char addr);
+unsigned int uart2_baud(void);
+int      uart2_bauderr(void);
+__weak void uart2_cbbauderr(void);
+unsigned int uart2_getline(char * buf, unsigned int size);
+__weak void uart2_cbrxline(void);
 
 //----------------------------------------------------------------------------
 #define  UART_3_CLK       SystemCoreClock >> 2
@@ -87,12 +252,36 @@ __weak void uart2_cbrxof(void);
 #define  UART3_TX   B,10, 7
 #define  RXBUF3_SIZE  64
 #define  TXBUF3_SIZE  64
+#define  URGBUF3_SIZE  0
 #define  UART3_PRINTF  0
-
+#define  UART3_LAZY_INIT  1
+#define  UART3_PRIORITY  UART_PRIORITY
+#define  UART3_SUBPRIORITY  0
+#define  UART3_RXHOOK  0
+#define  UART3_MUTE  0
+#define  UART3_OVER8  2
+#define  UART3_RXDMA  0, 0, 0
+#define  UART3_RXMATCH  '\n'
+
+void     uart3_init(void);
 char     uart3_sendchar(char c);
+unsigned int uart3_send(const char * buf, unsigned int len);
+char     uart3_txreserve(unsigned int len, struct uart_txspan * ts);
+void     uart3_txcommit(void);
+unsigned int uart3_send_urgent(const char * buf, unsigned int len);
 char     uart3_getchar(char * c);
 __weak void uart3_cbrx(char rxch);
 __weak void uart3_cbrxof(void);
+char     uart3_rxhook(char rxch, char err);
+void     uart3_rtoset(unsigned int bits);
+void     uart3_rtopoll(void);
+__weak void uart3_cbrto(void);
+void     uart3_mute(unsigned char addr);
+unsigned int uart3_baud(void);
+int      uart3_bauderr(void);
+__weak void uart3_cbbauderr(void);
+unsigned int uart3_getline(char * buf, unsigned int size);
+__weak void uart3_cbrxline(void);
 
 //----------------------------------------------------------------------------
 #define  UART_4_CLK       SystemCoreClock >> 2
@@ -101,12 +290,36 @@ __weak void uart3_cbrxof(void);
 #define  UART4_TX   A, 0, 8
 #define  RXBUF4_SIZE  64
 #define  TXBUF4_SIZE  64
+#define  URGBUF4_SIZE  0
 #define  UART4_PRINTF  0
-
+#define  UART4_LAZY_INIT  1
+#define  UART4_PRIORITY  UART_PRIORITY
+#define  UART4_SUBPRIORITY  0
+#define  UART4_RXHOOK  0
+#define  UART4_MUTE  0
+#define  UART4_OVER8  2
+#define  UART4_RXDMA  0, 0, 0
+#define  UART4_RXMATCH  '\n'
+
+void     uart4_init(void);
 char     uart4_sendchar(char c);
+unsigned int uart4_send(const char * buf, unsigned int len);
+char     uart4_txreserve(unsigned int len, struct uart_txspan * ts);
+void     uart4_txcommit(void);
+unsigned int uart4_send_urgent(const char * buf, unsigned int len);
 char     uart4_getchar(char * c);
 __weak void uart4_cbrx(char rxch);
 __weak void uart4_cbrxof(void);
+char     uart4_rxhook(char rxch, char err);
+void     uart4_rtoset(unsigned int bits);
+void     uart4_rtopoll(void);
+__weak void uart4_cbrto(void);
+void     uart4_mute(unsigned char addr);
+unsigned int uart4_baud(void);
+int      uart4_bauderr(void);
+__weak void uart4_cbbauderr(void);
+unsigned int uart4_getline(char * buf, unsigned int size);
+__weak void uart4_cbrxline(void);
 
 //----------------------------------------------------------------------------
 #define  UART_5_CLK       SystemCoreClock >> 2
@@ -115,12 +328,36 @@ __weak void uart4_cbrxof(void);
 #define  UART5_TX   C,12, 8
 #define  RXBUF5_SIZE  64
 #define  TXBUF5_SIZE  64
+#define  URGBUF5_SIZE  0
 #define  UART5_PRINTF  0
-
+#define  UART5_LAZY_INIT  1
+#define  UART5_PRIORITY  UART_PRIORITY
+#define  UART5_SUBPRIORITY  0
+#define  UART5_RXHOOK  0
+#define  UART5_MUTE  0
+#define  UART5_OVER8  2
+#define  UART5_RXDMA  0, 0, 0
+#define  UART5_RXMATCH  '\n'
+
+void     uart5_init(void);
 char     uart5_sendchar(char c);
+unsigned int uart5_send(const char * buf, unsigned int len);
+char     uart5_txreserve(unsigned int len, struct uart_txspan * ts);
+void     uart5_txcommit(void);
+unsigned int uart5_send_urgent(const char * buf, unsigned int len);
 char     uart5_getchar(char * c);
 __weak void uart5_cbrx(char rxch);
 __weak void uart5_cbrxof(void);
+char     uart5_rxhook(char rxch, char err);
+void     uart5_rtoset(unsigned int bits);
+void     uart5_rtopoll(void);
+__weak void uart5_cbrto(void);
+void     uart5_mute(unsigned char addr);
+unsigned int uart5_baud(void);
+int      uart5_bauderr(void);
+__weak void uart5_cbbauderr(void);
+unsigned int uart5_getline(char * buf, unsigned int size);
+__weak void uart5_cbrxline(void);
 
 //----------------------------------------------------------------------------
 #define  UART_6_CLK       SystemCoreClock >> 1
@@ -129,12 +366,36 @@ __weak void uart5_cbrxof(void);
 #define  UART6_TX   C, 6, 8
 #define  RXBUF6_SIZE  64
 #define  TXBUF6_SIZE  64
+#define  URGBUF6_SIZE  0
 #define  UART6_PRINTF  0
-
+#define  UART6_LAZY_INIT  1
+#define  UART6_PRIORITY  UART_PRIORITY
+#define  UART6_SUBPRIORITY  0
+#define  UART6_RXHOOK  0
+#define  UART6_MUTE  0
+#define  UART6_OVER8  2
+#define  UART6_RXDMA  0, 0, 0
+#define  UART6_RXMATCH  '\n'
+
+void     uart6_init(void);
 char     uart6_sendchar(char c);
+unsigned int uart6_send(const char * buf, unsigned int len);
+char     uart6_txreserve(unsigned int len, struct uart_txspan * ts);
+void     uart6_txcommit(void);
+unsigned int uart6_send_urgent(const char * buf, unsigned int len);
 char     uart6_getchar(char * c);
 __weak void uart6_cbrx(char rxch);
 __weak void uart6_cbrxof(void);
+char     uart6_rxhook(char rxch, char err);
+void     uart6_rtoset(unsigned int bits);
+void     uart6_rtopoll(void);
+__weak void uart6_cbrto(void);
+void     uart6_mute(unsigned char addr);
+unsigned int uart6_baud(void);
+int      uart6_bauderr(void);
+__weak void uart6_cbbauderr(void);
+unsigned int uart6_getline(char * buf, unsigned int size);
+__weak void uart6_cbrxline(void);
 
 //----------------------------------------------------------------------------
 #define  UART_7_CLK       SystemCoreClock >> 2
@@ -143,12 +404,36 @@ __weak void uart6_cbrxof(void);
 #define  UART7_TX   E, 8, 8
 #define  RXBUF7_SIZE  64
 #define  TXBUF7_SIZE  64
+#define  URGBUF7_SIZE  0
 #define  UART7_PRINTF  0
-
+#define  UART7_LAZY_INIT  1
+#define  UART7_PRIORITY  UART_PRIORITY
+#define  UART7_SUBPRIORITY  0
+#define  UART7_RXHOOK  0
+#define  UART7_MUTE  0
+#define  UART7_OVER8  2
+#define  UART7_RXDMA  0, 0, 0
+#define  UART7_RXMATCH  '\n'
+
+void     uart7_init(void);
 char     uart7_sendchar(char c);
+unsigned int uart7_send(const char * buf, unsigned int len);
+char     uart7_txreserve(unsigned int len, struct uart_txspan * ts);
+void     uart7_txcommit(void);
+unsigned int uart7_send_urgent(const char * buf, unsigned int len);
 char     uart7_getchar(char * c);
 __weak void uart7_cbrx(char rxch);
 __weak void uart7_cbrxof(void);
+char     uart7_rxhook(char rxch, char err);
+void     uart7_rtoset(unsigned int bits);
+void     uart7_rtopoll(void);
+__weak void uart7_cbrto(void);
+void     uart7_mute(unsigned char addr);
+unsigned int uart7_baud(void);
+int      uart7_bauderr(void);
+__weak void uart7_cbbauderr(void);
+unsigned int uart7_getline(char * buf, unsigned int size);
+__weak void uart7_cbrxline(void);
 
 //----------------------------------------------------------------------------
 #define  UART_8_CLK       SystemCoreClock >> 2
@@ -157,12 +442,41 @@ __weak void uart7_cbrxof(void);
 #define  UART8_TX   E, 1, 8
 #define  RXBUF8_SIZE  64
 #define  TXBUF8_SIZE  64
+#define  URGBUF8_SIZE  0
 #define  UART8_PRINTF  0
-
+#define  UART8_LAZY_INIT  1
+#define  UART8_PRIORITY  UART_PRIORITY
+#define  UART8_SUBPRIORITY  0
+#define  UART8_RXHOOK  0
+#define  UART8_MUTE  0
+#define  UART8_OVER8  2
+#define  UART8_RXDMA  0, 0, 0
+#define  UART8_RXMATCH  '\n'
+
+void     uart8_init(void);
 char     uart8_sendchar(char c);
+unsigned int uart8_send(const char * buf, unsigned int len);
+char     uart8_txreserve(unsigned int len, struct uart_txspan * ts);
+void     uart8_txcommit(void);
+unsigned int uart8_send_urgent(const char * buf, unsigned int len);
 char     uart8_getchar(char * c);
 __weak void uart8_cbrx(char rxch);
 __weak void uart8_cbrxof(void);
+char     uart8_rxhook(char rxch, char err);
+void     uart8_rtoset(unsigned int bits);
+void     uart8_rtopoll(void);
+__weak void uart8_cbrto(void);
+void     uart8_mute(unsigned char addr);
+unsigned int uart8_baud(void);
+int      uart8_bauderr(void);
+__weak void uart8_cbbauderr(void);
+unsigned int uart8_getline(char * buf, unsigned int size);
+__weak void uart8_cbrxline(void);
+
+//----------------------------------------------------------------------------
+void     uart_init_all(void);
+void     uart_priority_report(void);
+void     uart_baud_report(void);
 
 #ifdef __cplusplus
 }
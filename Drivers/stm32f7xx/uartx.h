@@ -13,31 +13,118 @@
 #define UARTX_TX  X, 0, 0
 #endif
 
+#if UARTX_MUTE > 0 && DMAX_NUM(UARTX_RXDMA) > 0
+#error "UARTx_MUTE can not be used with UARTx_RXDMA (see uart.h)"
+#endif
+
+#if UARTX_RXHOOK == 1 && DMAX_NUM(UARTX_RXDMA) > 0
+#error "UARTx_RXHOOK can not be used with UARTx_RXDMA (see uart.h)"
+#endif
+
+/* baud rate divider (clock / baud rate, rounded to the nearest) and the actual baud rate */
+#define UARTX_DIV             (((UARTX_CLK) + UARTX_BAUDRATE / 2) / UARTX_BAUDRATE)
+#define UARTX_BAUD_ACT        (((UARTX_CLK) + UARTX_DIV / 2) / UARTX_DIV)
+
+/* 8x oversampling (automatic: if the divider is less than 16), the divider in BRR: the 3 fraction bits
+   are not shifted (BRR[3] = 0), the minimum divider is 8 (16x oversampling: 16) */
+#define UARTX_OVER8_ON        (UARTX_OVER8 == 1 || (UARTX_OVER8 == 2 && UARTX_DIV < 16))
+#define UARTX_DIV_MIN         (UARTX_OVER8_ON ? 8 : 16)
+#define UARTX_BRR_CALC        (UARTX_OVER8_ON ? ((UARTX_DIV & ~7) << 1) | (UARTX_DIV & 7) : UARTX_DIV)
+
+/* compile time check of the baud rate error (only if the uart clock is a constant) */
+_Static_assert(__builtin_choose_expr(__builtin_constant_p(UARTX_CLK),
+               UARTX_DIV >= UARTX_DIV_MIN && (UARTX_BAUD_ACT > UARTX_BAUDRATE ? UARTX_BAUD_ACT - UARTX_BAUDRATE : UARTX_BAUDRATE - UARTX_BAUD_ACT) * 10000ULL
+               <= (unsigned long long)UART_BAUD_TOLERANCE * UARTX_BAUDRATE, 1),
+               "the baud rate error is larger than UART_BAUD_TOLERANCE (see uart.h)");
+
 #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A
 struct bufx_r {
   unsigned int in;                      /* Next In Index */
   unsigned int out;                     /* Next Out Index */
+  #if DMAX_NUM(UARTX_RXDMA) > 0
+  char buf [RXBUFX_SIZE] __attribute__((aligned(32))); /* Buffer (DMA, aligned to the cache line) */
+  #else
   char buf [RXBUFX_SIZE];               /* Buffer */
+  #endif
 };
 volatile static struct bufx_r rbufx = { 0, 0, };
 #define FIFO_RBUFLEN ((unsigned int)(rbufx.in - rbufx.out))
 __weak void uartx_cbrx(char rxch) { }
 __weak void uartx_cbrxof(void)  { }
+__weak void uartx_cbrto(void)  { }
+#if UARTX_MUTE > 0
+/* mute mode (multiprocessor communication) */
+static volatile unsigned char rxx_addr = 0;    /* node address */
+static volatile unsigned char rxx_mutereq = 0; /* NZ: enter the mute mode (requested by uartx_mute) */
+static unsigned char rxx_first = 0;            /* NZ: the next character is the address (after the idle line) */
+#endif
+#if DMAX_NUM(UARTX_RXDMA) > 0
+/* RX with DMA (circular, into rbufx.buf), rbufx.in is updated from the DMA counter */
+static volatile unsigned int rxx_mark = 0; /* rbufx.in at the last character match or idle line */
+__weak void uartx_cbrxline(void) { }
+#endif
 #endif
 
 #if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A
-static volatile unsigned int txx_restart = 1; /* NZ if TX restart is required */
+/* NZ if TX restart is required
+   only the interrupt writes it and the USART_CR1_TXEIE bit, uartx_sendchar only pends the interrupt,
+   so there is no read-modify-write of CR1 outside the interrupt (no lost TX start) */
+static volatile unsigned int txx_restart = 1;
 struct bufx_t {
-  unsigned int in;                      /* Next In Index */
+  unsigned int in;                      /* Next In Index (published to the interrupt) */
   unsigned int out;                     /* Next Out Index */
+  unsigned int res;                     /* Next Reserved Index */
+  unsigned int nest;                    /* Number of open reservations */
+  #if URGBUFX_SIZE >= 4
+  unsigned int cont [(TXBUFX_SIZE + 31) / 32]; /* Message continue bits (see txx_msgmark) */
+  #endif
   char buf [TXBUFX_SIZE];               /* Buffer */
 };
-volatile static struct bufx_t tbufx = { 0, 0, };
+volatile static struct bufx_t tbufx = { 0, 0, 0, 0, };
 #define FIFO_TBUFLEN ((unsigned int)(tbufx.in - tbufx.out))
+
+#if URGBUFX_SIZE >= 4
+struct bufx_u {
+  unsigned int in;                      /* Next In Index (published to the interrupt) */
+  unsigned int out;                     /* Next Out Index */
+  unsigned int res;                     /* Next Reserved Index */
+  unsigned int nest;                    /* Number of open reservations */
+  char buf [URGBUFX_SIZE];              /* Buffer */
+};
+volatile static struct bufx_u ubufx = { 0, 0, 0, 0, };
+static volatile unsigned int txx_urgent = 0; /* NZ if the interrupt sends an urgent message */
+static volatile unsigned int txx_inmsg = 0;  /* NZ if the last character sent from tbufx is not the end of its message */
+#endif
 #endif
 
 void uartx_init(void);
+#if UARTX_LAZY_INIT == 1
 static unsigned int uartx_inited = 0;  /* 0: not intit (call the uart_init), 1: after init */
+#endif
+
+#if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && DMAX_NUM(UARTX_RXDMA) > 0
+/* update rbufx.in from the DMA counter
+   the interrupt and the reader both call it: rbufx.in is read before the DMA counter and written with atomic max */
+static void rxx_dmasync(void)
+{
+  unsigned int in = rbufx.in;
+  unsigned int pos = RXBUFX_SIZE - DMAX_NDTR(UARTX_RXDMA);
+  if(SCB->CCR & SCB_CCR_DC_Msk)       /* the DMA wrote into the RAM, not into the data cache */
+    SCB_InvalidateDCache_by_Addr((uint32_t *)rbufx.buf, RXBUFX_SIZE);
+  uart_atomic_max(&rbufx.in, in + ((pos - in) & (RXBUFX_SIZE - 1)));
+}
+
+/* DMA overrun (reader side): the DMA has overwritten unread characters -> they are dropped
+   note: it is detected only if the DMA is less than one more buffer length ahead */
+static void rxx_dmaovr(void)
+{
+  if (rbufx.in - rbufx.out > RXBUFX_SIZE)
+  {
+    rbufx.out = rbufx.in;
+    uartx_cbrxof();                     /* buffer overflow! */
+  }
+}
+#endif
 
 
 /*----------------------------------------------------------------------------
@@ -50,40 +137,139 @@ void UARTX_IRQHandler(void)
 
   usr = UARTX->ISR;
 
-  #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A
+  #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && UARTX_MUTE > 0
+  if (rxx_mutereq)
+  {                                     /* enter the mute mode (requested by uartx_mute) */
+    #if UARTX_MUTE == 1
+    if (((UARTX->CR2 & USART_CR2_ADD) >> USART_CR2_ADD_Pos) != rxx_addr)
+    {                                   /* the address can only be written with UE = 0 (at the end of TX) */
+      if (!(usr & USART_ISR_TC))
+        UARTX->CR1 |= USART_CR1_TCIE;   /* TX in progress: no waiting here, it continues in the TC interrupt */
+      else
+      {
+        UARTX->CR1 &= ~(USART_CR1_UE | USART_CR1_TCIE);
+        UARTX->CR2 = (UARTX->CR2 & ~USART_CR2_ADD) | ((uint32_t)rxx_addr << USART_CR2_ADD_Pos);
+        UARTX->CR1 |= USART_CR1_UE;
+      }
+    }
+    if (!(UARTX->CR1 & USART_CR1_TCIE))
+    #endif
+    {
+      rxx_mutereq = 0;
+      rxx_first = 1;
+      UARTX->RQR = USART_RQR_MMRQ;
+    }
+  }
+  #endif
+
+  #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && DMAX_NUM(UARTX_RXDMA) == 0
   unsigned int udr;
   if (usr & USART_ISR_RXNE)
   {                                     /* RX */
     udr = UARTX->RDR;
-    uartx_cbrx((unsigned char)udr);
-    if(!(usr & (USART_ISR_ORE | USART_ISR_NE | USART_ISR_FE)))
+    #if UARTX_MUTE > 0
+    if (rxx_first || (udr & 0x100))
+    {                                   /* address character (after the idle line or with the 9th bit) */
+      rxx_first = ((unsigned char)udr != rxx_addr); /* not for this node: the first character after the wakeup is an address */
+      if (rxx_first)
+        UARTX->RQR = USART_RQR_MMRQ; /* mute to the next address (the wakeup by idle line does not set IDLE) */
+    }
+    else
+    #endif
     {
-      if (((rbufx.in - rbufx.out) & ~(RXBUFX_SIZE - 1)) == 0)
+      uartx_cbrx((unsigned char)udr);
+      #if UARTX_RXHOOK == 1
+      if(uartx_rxhook((char)udr, (usr & (USART_ISR_ORE | USART_ISR_NE | USART_ISR_FE)) ? 1 : 0))
+        ;                                 /* processed by the hook (not stored in the RX buffer) */
+      else
+      #endif
+      if(!(usr & (USART_ISR_ORE | USART_ISR_NE | USART_ISR_FE)))
       {
-        rbufx.buf [rbufx.in & (RXBUFX_SIZE - 1)] = (char)udr;
-        rbufx.in++;
+        if (((rbufx.in - rbufx.out) & ~(RXBUFX_SIZE - 1)) == 0)
+        {
+          rbufx.buf [rbufx.in & (RXBUFX_SIZE - 1)] = (char)udr;
+          rbufx.in++;
+        }
+        else
+          uartx_cbrxof();                 /* buffer overflow! */
       }
       else
-        uartx_cbrxof();                 /* buffer overflow! */
+        UARTX->ICR = USART_ICR_ORECF | USART_ICR_NCF | USART_ICR_FECF;
     }
-    else
-      UARTX->ICR = USART_ICR_ORECF | USART_ICR_NCF | USART_ICR_FECF;
+  }
+  #endif
+
+  #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && DMAX_NUM(UARTX_RXDMA) > 0
+  if (usr & (USART_ISR_CMF | USART_ISR_IDLE))
+  {                                     /* RX with DMA: character match or idle line */
+    UARTX->ICR = USART_ICR_CMCF | USART_ICR_IDLECF;
+    rxx_dmasync();
+    if (rxx_mark != rbufx.in)
+    {                                   /* new characters (the idle line after the match is not a new line) */
+      rxx_mark = rbufx.in;
+      uartx_cbrxline();
+    }
+  }
+  #endif
+
+  #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A
+  if (usr & USART_ISR_RTOF)
+  {                                     /* receiver timeout */
+    UARTX->ICR = USART_ICR_RTOCF;
+    uartx_cbrto();
+  }
+  #endif
+
+  #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && UARTX_MUTE == 2
+  if (usr & USART_ISR_IDLE)
+  {                                     /* idle line: the next character is the address */
+    UARTX->ICR = USART_ICR_IDLECF;
+    rxx_first = 1;
   }
   #endif
 
   #if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A
   if (usr & USART_ISR_TXE)
   {                                     /* TX */
+    #if URGBUFX_SIZE >= 4
+    if ((ubufx.in != ubufx.out) && (txx_urgent || !txx_inmsg || (tbufx.in == tbufx.out)))
+    {                                   /* urgent message first (only at a message boundary of tbufx) */
+      UARTX->TDR = ubufx.buf [ubufx.out & (URGBUFX_SIZE - 1)] & 0x00FF;
+      ubufx.out++;
+      txx_urgent = 1;
+      if (txx_restart)
+      {                                 /* TX restart (the interrupt was pended by uartx_send_urgent) */
+        txx_restart = 0;
+        UARTX->CR1 |= USART_CR1_TXEIE;  /* enable TX interrupt */
+      }
+    }
+    else
+    #endif
     if (tbufx.in != tbufx.out)
     {
+      #if URGBUFX_SIZE >= 4
+      txx_urgent = 0;
+      txx_inmsg = (tbufx.cont [(tbufx.out & (TXBUFX_SIZE - 1)) >> 5] >> (tbufx.out & (TXBUFX_SIZE - 1) & 31)) & 1;
+      #endif
       UARTX->TDR = tbufx.buf [tbufx.out & (TXBUFX_SIZE - 1)] & 0x00FF;
       tbufx.out++;
-      txx_restart = 0;
+      if (txx_restart)
+      {                                 /* TX restart (the interrupt was pended by uartx_sendchar) */
+        txx_restart = 0;
+        UARTX->CR1 |= USART_CR1_TXEIE;  /* enable TX interrupt */
+      }
     }
-    else
+    else if (!txx_restart)
     {
       txx_restart = 1;
       UARTX->CR1 &= ~USART_CR1_TXEIE;   /* disable TX interrupt if nothing to send */
+      /* a higher priority producer can publish between the check and txx_restart = 1 (it does not pend) */
+      #if URGBUFX_SIZE >= 4
+      if ((tbufx.in != tbufx.out) || (ubufx.in != ubufx.out))
+      #else
+      if (tbufx.in != tbufx.out)
+      #endif
+        NVIC->ISPR[(((uint32_t)(int32_t)UARTX_IRQn) >> 5UL)] = (uint32_t)(1UL << (((uint32_t)(int32_t)UARTX_IRQn) & 0x1FUL));
     }
   }
   #endif
@@ -95,11 +281,15 @@ void UARTX_IRQHandler(void)
 #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A
 char uartx_getchar(char * c)
 {
+  #if UARTX_LAZY_INIT == 1
   if(!uartx_inited)
-  {
     uartx_init();
-    uartx_inited = 1;
-  }
+  #endif
+
+  #if DMAX_NUM(UARTX_RXDMA) > 0
+  rxx_dmasync();
+  rxx_dmaovr();
+  #endif
 
   if (rbufx.in == rbufx.out)
     return 0;                           /* empty */
@@ -113,43 +303,293 @@ char uartx_getchar(char * c) { return 0; }
 #endif
 
 /*------------------------------------------------------------------------------
-  transmit a character
+  receive a line (with DMA: to the UARTX_RXMATCH character or to an idle line)
+  return: length of the line in buf (0: there is no complete line)
  *------------------------------------------------------------------------------*/
-#if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A
-char uartx_sendchar(char c)
+#if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && DMAX_NUM(UARTX_RXDMA) > 0
+unsigned int uartx_getline(char * buf, unsigned int size)
 {
+  unsigned int n, i = 0;
+  char c;
+
+  #if UARTX_LAZY_INIT == 1
   if(!uartx_inited)
+    uartx_init();
+  #endif
+
+  rxx_dmasync();
+  rxx_dmaovr();
+  n = rxx_mark - rbufx.out;
+  if((int)n <= 0)
+    return 0;                         /* no complete line */
+
+  while(i < n && i < size)
   {
+    c = rbufx.buf[(rbufx.out + i) & (RXBUFX_SIZE - 1)];
+    buf[i++] = c;
+    if(c == UARTX_RXMATCH)
+      break;
+  }
+  rbufx.out += i;
+  return i;
+}
+#else
+unsigned int uartx_getline(char * buf, unsigned int size) { return 0; }
+#endif
+
+/*------------------------------------------------------------------------------
+  receiver timeout (hardware: RTOR)
+  - bits: timeout after the last received character in bit time (0 = off)
+  note: when it expires, uartx_cbrto is called from the interrupt
+ *------------------------------------------------------------------------------*/
+#if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A
+void uartx_rtoset(unsigned int bits)
+{
+  #if UARTX_LAZY_INIT == 1
+  if(!uartx_inited)
     uartx_init();
-    uartx_inited = 1;
+  #endif
+
+  if(bits)
+  {
+    UARTX->RTOR = (UARTX->RTOR & ~USART_RTOR_RTO_Msk) | (bits & USART_RTOR_RTO_Msk);
+    UARTX->CR2 |= USART_CR2_RTOEN;
   }
+  else
+    UARTX->CR2 &= ~USART_CR2_RTOEN;
+}
 
-  while(FIFO_TBUFLEN >= TXBUFX_SIZE);
+/* not needed (hardware receiver timeout), only for compatibility with the other families */
+void uartx_rtopoll(void) { }
+#else
+void uartx_rtoset(unsigned int bits) { }
+void uartx_rtopoll(void) { }
+#endif
+
+/*------------------------------------------------------------------------------
+  enter the mute mode (the frames of the other nodes are discarded by the hardware)
+  - addr: node address
+  note: the mute mode is set in the interrupt (only the interrupt writes CR1)
+ *------------------------------------------------------------------------------*/
+#if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && UARTX_MUTE > 0
+void uartx_mute(unsigned char addr)
+{
+  #if UARTX_LAZY_INIT == 1
+  if(!uartx_inited)
+    uartx_init();
+  #endif
 
-  tbufx.buf[tbufx.in & (TXBUFX_SIZE - 1)] = c; /* Add data to the transmit buffer */
-  tbufx.in++;
+  rxx_addr = addr;
+  rxx_mutereq = 1;
+  NVIC->ISPR[(((uint32_t)(int32_t)UARTX_IRQn) >> 5UL)] = (uint32_t)(1UL << (((uint32_t)(int32_t)UARTX_IRQn) & 0x1FUL));
+}
+#else
+void uartx_mute(unsigned char addr) { }
+#endif
 
-  if (txx_restart)
-  {                                     /* If transmit interrupt is disabled, enable it */
-    txx_restart = 0;
-    UARTX->CR1 |= USART_CR1_TXEIE;      /* enable TX interrupt */
+/*------------------------------------------------------------------------------
+  mark the message boundary in tbufx.cont (bit = 1: the message continues, 0: last character)
+ *------------------------------------------------------------------------------*/
+#if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A && URGBUFX_SIZE >= 4
+static void txx_msgmark(unsigned int pos, unsigned int len)
+{
+  unsigned int i, n, m;
+  while(len)
+  {
+    i = pos & (TXBUFX_SIZE - 1);
+    n = 32 - (i & 31);                  /* to the end of the 32 bit word or the buffer */
+    if(n > TXBUFX_SIZE - i)
+      n = TXBUFX_SIZE - i;
+    if(n > len)
+      n = len;
+    m = (n == 32) ? 0xFFFFFFFF : ((1U << n) - 1) << (i & 31);
+    uart_atomic_bits(&tbufx.cont[i >> 5], m, (n == len) ? m & ~(1U << ((i + n - 1) & 31)) : m);
+    pos += n;
+    len -= n;
+  }
+}
+#endif
+
+/*------------------------------------------------------------------------------
+  close a reservation of a TX buffer (tbufx or ubufx)
+  the last closed reservation publishes all reserved areas to the interrupt
+  return: number of the reservations still open
+ *------------------------------------------------------------------------------*/
+#if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A
+static unsigned int txx_commit(volatile unsigned int * nest, volatile unsigned int * in, volatile unsigned int * res)
+{
+  unsigned int n;
+  __DMB();                              /* the characters are in the buffer before publishing */
+  n = uart_atomic_add(nest, -1);
+  if(n == 0)
+  {                                     /* there is no open reservation: all reserved areas are filled */
+    uart_atomic_max(in, *res);
+    if (txx_restart)                    /* If transmit interrupt is disabled, pend the uart interrupt */
+      NVIC->ISPR[(((uint32_t)(int32_t)UARTX_IRQn) >> 5UL)] = (uint32_t)(1UL << (((uint32_t)(int32_t)UARTX_IRQn) & 0x1FUL));
+  }
+  return n;
+}
+#endif
+
+/*------------------------------------------------------------------------------
+  reserve space in the TX buffer
+  - len: number of characters
+  - ts: the reserved area (2 parts if it wraps the end of the buffer)
+  return: 1 = ok (the area must be filled and closed with uartx_txcommit), 0 = not enough free space
+  note: it can be called from the main program and from interrupts at the same time
+ *------------------------------------------------------------------------------*/
+#if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A
+char uartx_txreserve(unsigned int len, struct uart_txspan * ts)
+{
+  unsigned int pos;
+
+  #if UARTX_LAZY_INIT == 1
+  if(!uartx_inited)
+    uartx_init();
+  #endif
+
+  /* first the open reservation counter, so that an interrupting producer does not publish this area */
+  uart_atomic_add(&tbufx.nest, 1);
+  if(!uart_atomic_reserve(&tbufx.res, &tbufx.out, len, TXBUFX_SIZE, &pos))
+  {
+    uartx_txcommit();
+    return 0;
+  }
+
+  #if URGBUFX_SIZE >= 4
+  txx_msgmark(pos, len);
+  #endif
+
+  pos &= TXBUFX_SIZE - 1;
+  ts->p1 = (char *)&tbufx.buf[pos];
+  if(pos + len <= TXBUFX_SIZE)
+  {
+    ts->n1 = len;
+    ts->p2 = (char *)&tbufx.buf[0];
+    ts->n2 = 0;
+  }
+  else
+  {
+    ts->n1 = TXBUFX_SIZE - pos;
+    ts->p2 = (char *)&tbufx.buf[0];
+    ts->n2 = len - ts->n1;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+  close the reservation (the last closed reservation publishes all reserved areas to the interrupt)
+ *------------------------------------------------------------------------------*/
+void uartx_txcommit(void)
+{
+  txx_commit(&tbufx.nest, &tbufx.in, &tbufx.res);
+}
+
+/*------------------------------------------------------------------------------
+  transmit a message (the characters of the message are not mixed with other messages)
+  return: number of characters placed in the TX buffer
+  note: if the TX buffer is full, in the main program it will wait until there is free space in it,
+        in interrupt (or if an interrupted producer has an open reservation) it returns without waiting
+ *------------------------------------------------------------------------------*/
+unsigned int uartx_send(const char * buf, unsigned int len)
+{
+  struct uart_txspan ts;
+  unsigned int n, sent = 0;
+
+  while(len)
+  {
+    n = (len > TXBUFX_SIZE) ? TXBUFX_SIZE : len;
+    while(!uartx_txreserve(n, &ts))
+    {
+      if(tbufx.nest || __get_IPSR())
+        return sent;
+    }
+    memcpy(ts.p1, buf, ts.n1);
+    memcpy(ts.p2, buf + ts.n1, ts.n2);
+    uartx_txcommit();
+    buf += n;
+    len -= n;
+    sent += n;
+  }
+  return sent;
+}
+
+/*------------------------------------------------------------------------------
+  transmit a character
+ *------------------------------------------------------------------------------*/
+char uartx_sendchar(char c)
+{
+  struct uart_txspan ts;
+
+  while(!uartx_txreserve(1, &ts))
+  {
+    if(tbufx.nest || __get_IPSR())
+      return 0;
   }
+  *ts.p1 = c;                           /* Add data to the transmit buffer */
+  uartx_txcommit();
 
   return (0);
 }
 #else
+char uartx_txreserve(unsigned int len, struct uart_txspan * ts) { return 0; }
+void uartx_txcommit(void) { }
+unsigned int uartx_send(const char * buf, unsigned int len) { return 0; }
 char uartx_sendchar(char c) { return 0; }
 #endif
 
+/*------------------------------------------------------------------------------
+  transmit an urgent message (before the characters waiting in the TX buffer)
+  return: number of characters placed in the urgent TX buffer (0 or len)
+  note: if the urgent TX buffer is full, in the main program it will wait until there is free space in it,
+        in interrupt (or if an interrupted producer has an open reservation) it returns without waiting
+ *------------------------------------------------------------------------------*/
+#if GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A && URGBUFX_SIZE >= 4
+unsigned int uartx_send_urgent(const char * buf, unsigned int len)
+{
+  unsigned int pos, i;
+
+  if(len > URGBUFX_SIZE)
+    return 0;
+
+  #if UARTX_LAZY_INIT == 1
+  if(!uartx_inited)
+    uartx_init();
+  #endif
+
+  while(1)
+  {
+    uart_atomic_add(&ubufx.nest, 1);
+    if(uart_atomic_reserve(&ubufx.res, &ubufx.out, len, URGBUFX_SIZE, &pos))
+      break;
+    /* a failed reservation can close the last one: it publishes the areas of the interrupted producers */
+    if(txx_commit(&ubufx.nest, &ubufx.in, &ubufx.res) || __get_IPSR())
+      return 0;
+  }
+
+  for(i = 0; i < len; i++)
+    ubufx.buf[(pos + i) & (URGBUFX_SIZE - 1)] = buf[i];
+
+  txx_commit(&ubufx.nest, &ubufx.in, &ubufx.res);
+  return len;
+}
+#else
+unsigned int uartx_send_urgent(const char * buf, unsigned int len) { return 0; }
+#endif
+
 /*------------------------------------------------------------------------------
   initialize the buffers
  *------------------------------------------------------------------------------*/
 void uartx_init(void)
 {
+  #if UARTX_LAZY_INIT == 1
+  uartx_inited = 1;
+  #endif
+
   UARTX_CLOCLK_ON;
 
   #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && GPIOX_PORTNUM(UARTX_TX) >= GPIOX_PORTNUM_A
-  #define UARTX_CR1_RXNEIE       USART_CR1_RXNEIE
+  #define UARTX_CR1_RXNEIE       (USART_CR1_RXNEIE | USART_CR1_RTOIE)
   #define UARTX_CR1_RE           USART_CR1_RE
   #define UARTX_CR1_TE           USART_CR1_TE
   RCC->AHB1ENR |= GPIOX_CLOCK(UARTX_RX) | GPIOX_CLOCK(UARTX_TX);
@@ -158,7 +598,7 @@ void uartx_init(void)
   GPIOX_AFR(UARTX_RX);
   GPIOX_AFR(UARTX_TX);
   #elif GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A
-  #define UARTX_CR1_RXNEIE       USART_CR1_RXNEIE
+  #define UARTX_CR1_RXNEIE       (USART_CR1_RXNEIE | USART_CR1_RTOIE)
   #define UARTX_CR1_RE           USART_CR1_RE
   #define UARTX_CR1_TE           0
   RCC->AHB1ENR |= GPIOX_CLOCK(UARTX_RX);
@@ -173,16 +613,60 @@ void uartx_init(void)
   GPIOX_AFR(UARTX_TX);
   #endif
 
+  #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && DMAX_NUM(UARTX_RXDMA) > 0
+  /* RX with DMA (circular) and character match interrupt */
+  RCC->AHB1ENR |= DMAX_CLOCK(UARTX_RXDMA);
+  DMAX_STREAM(UARTX_RXDMA)->CR = 0;
+  while(DMAX_STREAM(UARTX_RXDMA)->CR & DMA_SxCR_EN);
+  DMAX_STREAM(UARTX_RXDMA)->PAR = (uint32_t)&UARTX->RDR;
+  DMAX_STREAM(UARTX_RXDMA)->M0AR = (uint32_t)rbufx.buf;
+  DMAX_STREAM(UARTX_RXDMA)->NDTR = RXBUFX_SIZE;
+  DMAX_STREAM(UARTX_RXDMA)->CR = DMAX_CHSEL(UARTX_RXDMA) | DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_EN;
+  UARTX->CR2 = (UARTX->CR2 & ~USART_CR2_ADD) | ((uint32_t)(unsigned char)UARTX_RXMATCH << USART_CR2_ADD_Pos) | USART_CR2_ADDM7;
+  UARTX->CR3 |= USART_CR3_DMAR;
+  #undef  UARTX_CR1_RXNEIE
+  #define UARTX_CR1_RXNEIE       (USART_CR1_CMIE | USART_CR1_IDLEIE | USART_CR1_RTOIE)
+  #endif
+
+  #if GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && UARTX_MUTE == 1
+  #define UARTX_CR1_MUTE         (USART_CR1_WAKE | USART_CR1_M0 | USART_CR1_MME) /* address mark wakeup, 9 bit characters */
+  UARTX->CR2 |= USART_CR2_ADDM7;        /* 8 bit address (in 9 bit mode) */
+  #elif GPIOX_PORTNUM(UARTX_RX) >= GPIOX_PORTNUM_A && UARTX_MUTE == 2
+  #define UARTX_CR1_MUTE         (USART_CR1_IDLEIE | USART_CR1_MME) /* idle line wakeup */
+  #else
+  #define UARTX_CR1_MUTE         0
+  #endif
+
   /* Enable the USARTx Interrupt */
+  NVIC_SetPriority(UARTX_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), UARTX_PRIORITY, UARTX_SUBPRIORITY));
   NVIC->ISER[(((uint32_t)(int32_t)UARTX_IRQn) >> 5UL)] = (uint32_t)(1UL << (((uint32_t)(int32_t)UARTX_IRQn) & 0x1FUL));
-  NVIC->IP[((uint32_t)(int32_t)UARTX_IRQn)] = (uint8_t)((UART_PRIORITY << (8U - __NVIC_PRIO_BITS)) & (uint32_t)0xFFUL);
 
-  UARTX->CR1 = UARTX_CR1_RXNEIE | UARTX_CR1_TE | UARTX_CR1_RE | USART_CR1_PEIE;
+  UARTX->CR1 = UARTX_CR1_RXNEIE | UARTX_CR1_TE | UARTX_CR1_RE | USART_CR1_PEIE | UARTX_CR1_MUTE |
+               (UARTX_OVER8_ON ? USART_CR1_OVER8 : 0);
   UARTX->BRR = UARTX_BRR_CALC;
   UARTX->CR1 |= USART_CR1_UE;
   #undef UARTX_CR1_RXNEIE
   #undef UARTX_CR1_RE
   #undef UARTX_CR1_TE
+  #undef UARTX_CR1_MUTE
+
+  if(UARTX_DIV < UARTX_DIV_MIN || uartx_bauderr() > UART_BAUD_TOLERANCE || uartx_bauderr() < -UART_BAUD_TOLERANCE)
+    uartx_cbbauderr();                  /* the baud rate is not accurate enough */
+}
+
+/*------------------------------------------------------------------------------
+  actual baud rate and its error (0.01 %)
+ *------------------------------------------------------------------------------*/
+__weak void uartx_cbbauderr(void) { }
+
+unsigned int uartx_baud(void)
+{
+  return UARTX_BAUD_ACT;
+}
+
+int uartx_bauderr(void)
+{
+  return (int)(((long long)UARTX_BAUD_ACT - UARTX_BAUDRATE) * 10000 / UARTX_BAUDRATE);
 }
 
 /*------------------------------------------------------------------------------
@@ -192,34 +676,71 @@ void uartx_init(void)
 int _write (int fd, char *ptr, int len)
 {
   int i = 0;
-  while (*ptr && (i < len))
-  {
-    uartx_sendchar(*ptr);
+  while ((i < len) && ptr[i])
     i++;
-    ptr++;
-  }
-  return i;
+  return uartx_send(ptr, i);  /* one message (not mixed with the other producers) */
 }
 #endif
 
 #undef  UARTX
 #undef  UARTX_IRQHandler
 #undef  UARTX_IRQn
+#undef  UARTX_PRIORITY
+#undef  UARTX_SUBPRIORITY
 #undef  UARTX_CLOCLK_ON
+#undef  UARTX_CLK
 #undef  UARTX_BRR_CALC
+#undef  UARTX_BAUD_ACT
+#undef  UARTX_DIV
+#undef  UARTX_DIV_MIN
+#undef  UARTX_OVER8_ON
 #undef  UARTX_RX
 #undef  UARTX_TX
 #undef  RXBUFX_SIZE
 #undef  TXBUFX_SIZE
+#undef  URGBUFX_SIZE
 #undef  UARTX_PRINTF
+#undef  UARTX_LAZY_INIT
+#undef  UARTX_RXHOOK
+#undef  UARTX_MUTE
+#undef  UARTX_OVER8
+#undef  UARTX_RXDMA
+#undef  UARTX_RXMATCH
+#undef  UARTX_BAUDRATE
 #undef  uartx_inited
 #undef  txx_restart
+#undef  rxx_addr
+#undef  rxx_mutereq
+#undef  rxx_first
+#undef  rxx_mark
+#undef  rxx_dmasync
+#undef  rxx_dmaovr
+#undef  txx_urgent
+#undef  txx_inmsg
+#undef  txx_msgmark
+#undef  txx_commit
 #undef  bufx_r
 #undef  bufx_t
+#undef  bufx_u
 #undef  rbufx
 #undef  tbufx
+#undef  ubufx
 #undef  uartx_init
 #undef  uartx_sendchar
+#undef  uartx_send
+#undef  uartx_send_urgent
+#undef  uartx_txreserve
+#undef  uartx_txcommit
 #undef  uartx_getchar
 #undef  uartx_cbrx
 #undef  uartx_cbrxof
+#undef  uartx_rxhook
+#undef  uartx_rtoset
+#undef  uartx_rtopoll
+#undef  uartx_cbrto
+#undef  uartx_mute
+#undef  uartx_baud
+#undef  uartx_bauderr
+#undef  uartx_cbbauderr
+#undef  uartx_getline
+#undef  uartx_cbrxline
@@ -0,0 +1,130 @@
+/* Host throughput benchmark of the COBS layer (Drivers/protocol/cobs.c)
+
+   Build: gcc -O2 -c -I host -I ../Drivers/stm32f4xx -I ../Drivers/protocol ../Drivers/protocol/cobs.c ../Drivers/protocol/uart_proto.c
+          g++ -std=c++11 -O2 -I host -I ../Drivers/stm32f4xx -I ../Drivers/protocol -o cobs_bench cobs_bench.cpp cobs.o uart_proto.o
+   Usage: cobs_bench [MB per test (default 64)]
+          the driver code is measured: cobs_enclen + cobs_encode into a reserved area (wrapping the end of the TX ring)
+          and cobs_rx character by character into a frame queue (as from uartx_rxhook),
+          every frame is checked after the round trip
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "main.h"
+#include "cobs.h"
+
+namespace {
+
+const unsigned int RING = 4096;         /* TXBUFX_SIZE and the frame queue buffer size */
+
+double now_s()
+{
+  using namespace std::chrono;
+  return duration_cast<duration<double> >(steady_clock::now().time_since_epoch()).count();
+}
+
+/* payload patterns */
+void fill(std::vector<unsigned char> & f, int pattern, unsigned int seed)
+{
+  for(size_t i = 0; i < f.size(); i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    unsigned char r = (unsigned char)(seed >> 16);
+    switch(pattern)
+    {
+      case 0: f[i] = r; break;                          /* random (1/256 zeros) */
+      case 1: f[i] = r ? r : 1; break;                  /* no zeros (254 character blocks) */
+      case 2: f[i] = (r & 3) ? 0 : r; break;            /* mostly zeros (sensor data) */
+      default: f[i] = 0; break;                         /* all zeros */
+    }
+  }
+}
+
+const char * pattern_name[] = { "random", "no zeros", "75% zeros", "all zeros" };
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  double mb = argc > 1 ? atof(argv[1]) : 64;
+  static char ring[RING];
+  static char qbuf[RING];
+  static unsigned int qlen[16];
+  const unsigned int sizes[] = { 16, 64, 256, 1024 };
+  bool ok = true;
+
+  printf("%-10s %6s %12s %12s %10s\n", "payload", "frame", "encode MB/s", "decode MB/s", "overhead");
+  for(int pattern = 0; pattern < 4; pattern++)
+    for(unsigned int size : sizes)
+    {
+      const unsigned int NFRAME = 64;   /* different frames, to defeat the branch predictor */
+      std::vector<std::vector<unsigned char> > frames(NFRAME, std::vector<unsigned char>(size));
+      for(unsigned int i = 0; i < NFRAME; i++)
+        fill(frames[i], pattern, i * 7919 + size);
+      unsigned long count = (unsigned long)(mb * 1e6 / size) + 1;
+
+      /* encode: the reserved area starts before the end of the ring (2 parts) */
+      unsigned long enc_bytes = 0;
+      volatile unsigned char sink = 0;
+      double t0 = now_s();
+      for(unsigned long k = 0; k < count; k++)
+      {
+        const std::vector<unsigned char> & f = frames[k % NFRAME];
+        unsigned int n = cobs_enclen(f.data(), size);
+        unsigned int pos = (RING - n / 2) & (RING - 1);
+        struct uart_txspan ts;
+        ts.p1 = &ring[pos];
+        ts.n1 = RING - pos < n ? RING - pos : n;
+        ts.p2 = &ring[0];
+        ts.n2 = n - ts.n1;
+        cobs_encode(&ts, f.data(), size);
+        sink ^= ring[pos];
+        enc_bytes += n;
+      }
+      double tenc = now_s() - t0;
+
+      /* the encoded stream of the frames (linear, for the decoder) */
+      std::vector<char> stream;
+      for(unsigned int i = 0; i < NFRAME; i++)
+      {
+        unsigned int n = cobs_enclen(frames[i].data(), size);
+        struct uart_txspan ts = { ring, n, ring, 0 };
+        cobs_encode(&ts, frames[i].data(), size);
+        stream.insert(stream.end(), ring, ring + n);
+      }
+
+      /* decode: one character at a time into the frame queue, the application reads the frames */
+      struct uart_frameq q = UART_FRAMEQ_INIT(qbuf, qlen);
+      struct cobs_rx d = COBS_RX_INIT(&q);
+      struct uart_frame fr;
+      std::vector<unsigned char> out(size);
+      unsigned long rounds = count / NFRAME + 1, got = 0;
+      t0 = now_s();
+      for(unsigned long k = 0; k < rounds; k++)
+        for(size_t i = 0; i < stream.size(); i++)
+        {
+          cobs_rx(&d, stream[i], 0);
+          if(uart_frameq_get(&q, &fr))
+          {
+            if(!k && (uart_frame_copy(&fr, out.data(), size) != size || fr.n1 + fr.n2 != size ||
+                      memcmp(out.data(), frames[got].data(), size)))
+              ok = false;
+            got++;
+            uart_frameq_free(&q);
+          }
+        }
+      double tdec = now_s() - t0;
+      if(got != rounds * NFRAME || q.lost)
+        ok = false;
+
+      printf("%-10s %6u %12.1f %12.1f %9.2f%%\n", pattern_name[pattern], size,
+             count * size / tenc / 1e6, rounds * NFRAME * size / tdec / 1e6,
+             100.0 * ((double)enc_bytes / count - size) / size);
+    }
+  printf("%s\n", ok ? "round trip ok" : "ROUND TRIP ERROR");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+/* Host benchmark of the CRC-32 software calculation (Drivers/protocol/uart_crc.c): byte by byte vs slicing-by-8
+
+   Build: gcc -O2 -c -I host -I ../Drivers/stm32f4xx -I ../Drivers/protocol ../Drivers/protocol/uart_crc.c
+          g++ -std=c++11 -O2 -I host -I ../Drivers/stm32f4xx -I ../Drivers/protocol -o crc_bench crc_bench.cpp uart_crc.o
+   Usage: crc_bench [MB per test (default 256)]
+          byte by byte: crc32_byte (the 1 kbyte table, UART_CRC32_SLICING = 1),
+          slicing-by-8: crc32 (the 8 kbyte tables, the default),
+          the buffers start at odd addresses too (the frame queue and the DMA ring are not aligned),
+          the results of the two methods are compared
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "main.h"
+#include "uart_crc.h"
+
+namespace {
+
+double now_s()
+{
+  using namespace std::chrono;
+  return duration_cast<duration<double> >(steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t crc32_bytewise(uint32_t crc, const unsigned char * p, unsigned int len)
+{
+  while(len--)
+    crc = crc32_byte(crc, (char)*p++);
+  return crc;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  double mb = argc > 1 ? atof(argv[1]) : 256;
+  const unsigned int sizes[] = { 8, 16, 64, 256, 1024, 4096 };
+  std::vector<unsigned char> buf(4096 + 8);
+  bool ok = ~crc32(UART_CRC32_INIT, "123456789", 9) == 0xCBF43926;
+
+  srand(1);
+  for(size_t i = 0; i < buf.size(); i++)
+    buf[i] = (unsigned char)rand();
+
+  printf("%6s %14s %14s %8s\n", "length", "bytewise MB/s", "slicing MB/s", "speedup");
+  for(unsigned int size : sizes)
+  {
+    unsigned long count = (unsigned long)(mb * 1e6 / size) + 1;
+    volatile uint32_t sink = 0;
+    uint32_t c1 = UART_CRC32_INIT, c2 = UART_CRC32_INIT;
+
+    double t0 = now_s();
+    for(unsigned long k = 0; k < count; k++)
+      c1 = crc32_bytewise(c1, &buf[k & 7], size);
+    double tb = now_s() - t0;
+    sink = c1;
+
+    t0 = now_s();
+    for(unsigned long k = 0; k < count; k++)
+      c2 = crc32(c2, &buf[k & 7], size);
+    double ts = now_s() - t0;
+    sink = c2;
+    (void)sink;
+
+    if(c1 != c2)
+      ok = false;
+    printf("%6u %14.1f %14.1f %7.2fx\n", size, count * size / tb / 1e6, count * size / ts / 1e6, tb / ts);
+  }
+  printf("%s\n", ok ? "results ok" : "RESULT ERROR");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+/* Host side decoder of the deferred binary log (Drivers/protocol/dlog.h)
+
+   The format strings (and the %s string constants) are read from the ELF file of the program.
+
+   Build: g++ -std=c++11 -O2 -o dlog_decode dlog_decode.cpp
+   Usage: dlog_decode <ELF file> [log file or serial device (default: stdin)]
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <elf.h>
+
+namespace {
+
+/* contents of the ELF sections (address -> data) */
+class ElfImage
+{
+public:
+  bool load(const char * name)
+  {
+    FILE * f = fopen(name, "rb");
+    if(!f)
+      return false;
+    std::vector<unsigned char> img;
+    unsigned char buf[4096];
+    size_t n;
+    while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+      img.insert(img.end(), buf, buf + n);
+    fclose(f);
+
+    if(img.size() < sizeof(Elf32_Ehdr) || memcmp(img.data(), ELFMAG, SELFMAG) || img[EI_CLASS] != ELFCLASS32)
+      return false;
+    Elf32_Ehdr eh;
+    memcpy(&eh, img.data(), sizeof(eh));
+    std::vector<Elf32_Shdr> shdr(eh.e_shnum);
+    for(unsigned int i = 0; i < eh.e_shnum; i++)
+    {
+      size_t o = eh.e_shoff + (size_t)i * eh.e_shentsize;
+      if(o + sizeof(Elf32_Shdr) > img.size())
+        return false;
+      memcpy(&shdr[i], img.data() + o, sizeof(Elf32_Shdr));
+    }
+
+    /* the section names */
+    const Elf32_Shdr * names = eh.e_shstrndx < shdr.size() ? &shdr[eh.e_shstrndx] : nullptr;
+    if(names && (size_t)names->sh_offset + names->sh_size > img.size())
+      names = nullptr;
+
+    /* only the loaded sections (flash, initialized RAM) and .dlog (not loaded, the format strings from address 0),
+       the debug sections would overlap with .dlog, .dlog is the first one (looked up first) */
+    for(const Elf32_Shdr & sh : shdr)
+    {
+      if(sh.sh_type != SHT_PROGBITS || (size_t)sh.sh_offset + sh.sh_size > img.size())
+        continue;
+      bool dlog = names && sh.sh_name < names->sh_size &&
+                  !strncmp((const char *)img.data() + names->sh_offset + sh.sh_name, ".dlog", names->sh_size - sh.sh_name);
+      if(!dlog && !(sh.sh_flags & SHF_ALLOC))
+        continue;
+      Section s;
+      s.addr = sh.sh_addr;
+      s.data.assign(img.begin() + sh.sh_offset, img.begin() + sh.sh_offset + sh.sh_size);
+      if(dlog)
+        sec_.insert(sec_.begin(), s);
+      else
+        sec_.push_back(s);
+    }
+    return true;
+  }
+
+  /* zero terminated string at the address (0 = not found) */
+  const char * str(uint32_t addr) const
+  {
+    for(const Section & s : sec_)
+      if(addr >= s.addr && addr < s.addr + s.data.size() &&
+         memchr(s.data.data() + (addr - s.addr), 0, s.data.size() - (addr - s.addr)))
+        return (const char *)s.data.data() + (addr - s.addr);
+    return nullptr;
+  }
+
+private:
+  struct Section
+  {
+    uint32_t addr;
+    std::vector<unsigned char> data;
+  };
+  std::vector<Section> sec_;
+};
+
+/* COBS decoding of one frame (without the delimiter) */
+bool cobs_decode(const std::vector<unsigned char> & in, std::vector<unsigned char> & out)
+{
+  size_t i = 0;
+  while(i < in.size())
+  {
+    unsigned char code = in[i++];
+    if(!code || i + code - 1 > in.size())
+      return false;
+    out.insert(out.end(), in.begin() + i, in.begin() + i + code - 1);
+    i += code - 1;
+    if(code != 0xFF && i < in.size())
+      out.push_back(0);
+  }
+  return !out.empty();
+}
+
+/* format the record with the format string (only the 32 bit integer conversions and %s, %c, %p) */
+std::string format(const ElfImage & elf, const char * fmt, const std::vector<uint32_t> & arg)
+{
+  std::string r;
+  size_t a = 0;
+  char buf[256];
+
+  while(*fmt)
+  {
+    if(*fmt != '%')
+    {
+      r += *fmt++;
+      continue;
+    }
+    const char * s = fmt++;
+    if(*fmt == '%')
+    {
+      r += *fmt++;
+      continue;
+    }
+    while(*fmt && strchr("-+ #0123456789.", *fmt))
+      fmt++;
+    std::string spec(s, fmt - s);       /* flags, width, precision (without the length modifier) */
+    while(*fmt && strchr("hlzjt", *fmt))
+      fmt++;
+    char conv = *fmt ? *fmt++ : 0;
+    uint32_t v = a < arg.size() ? arg[a++] : 0;
+    switch(conv)
+    {
+      case 'd': case 'i':
+        snprintf(buf, sizeof(buf), (spec + "d").c_str(), (int32_t)v);
+        break;
+      case 'u': case 'x': case 'X': case 'o': case 'c':
+        snprintf(buf, sizeof(buf), (spec + conv).c_str(), v);
+        break;
+      case 'p':
+        snprintf(buf, sizeof(buf), "0x%08X", v);
+        break;
+      case 's':
+      {
+        const char * str = elf.str(v);
+        snprintf(buf, sizeof(buf), (spec + "s").c_str(), str ? str : "<?>");
+        break;
+      }
+      default:
+        snprintf(buf, sizeof(buf), "<%%%c?>", conv);
+        break;
+    }
+    r += buf;
+  }
+  return r;
+}
+
+/* decode and print one record */
+void record(const ElfImage & elf, const std::vector<unsigned char> & rec)
+{
+  std::vector<uint32_t> v;
+  uint32_t x = 0;
+  unsigned int sh = 0;
+  for(unsigned char c : rec)
+  {
+    x |= (uint32_t)(c & 0x7F) << sh;
+    sh += 7;
+    if(!(c & 0x80))
+    {
+      v.push_back(x);
+      x = 0;
+      sh = 0;
+    }
+  }
+  if(v.size() < 2)
+  {
+    printf("<invalid record>\n");
+    return;
+  }
+  const char * fmt = elf.str(v[0]);
+  std::vector<uint32_t> arg(v.begin() + 2, v.end());
+  if(fmt)
+    printf("[%10u] %s\n", v[1], format(elf, fmt, arg).c_str());
+  else
+    printf("[%10u] <unknown format 0x%08X>\n", v[1], v[0]);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  if(argc < 2)
+  {
+    fprintf(stderr, "usage: %s <ELF file> [log file or serial device]\n", argv[0]);
+    return 1;
+  }
+  ElfImage elf;
+  if(!elf.load(argv[1]))
+  {
+    fprintf(stderr, "%s: not a 32 bit ELF file\n", argv[1]);
+    return 1;
+  }
+  FILE * in = stdin;
+  if(argc > 2 && !(in = fopen(argv[2], "rb")))
+  {
+    perror(argv[2]);
+    return 1;
+  }
+
+  std::vector<unsigned char> frame;
+  int c;
+  while((c = fgetc(in)) != EOF)
+  {
+    if(c)
+    {
+      if(frame.size() < 1024)
+        frame.push_back((unsigned char)c);
+      continue;
+    }
+    std::vector<unsigned char> rec;
+    if(cobs_decode(frame, rec))
+    {
+      record(elf, rec);
+      fflush(stdout);
+    }
+    frame.clear();
+  }
+  return 0;
+}
@@ -0,0 +1,134 @@
+/* Host comparison of the lightweight printf (Drivers/protocol/uart_fmt.c) with the vsnprintf of the C library
+
+   Build: gcc -O2 -c -I host -I ../Drivers/stm32f4xx -I ../Drivers/protocol ../Drivers/protocol/uart_fmt.c ../Drivers/protocol/uart_proto.c
+          g++ -std=c++11 -O2 -I host -I ../Drivers/stm32f4xx -I ../Drivers/protocol -o fmt_bench fmt_bench.cpp uart_fmt.o uart_proto.o
+          the stack of the single functions: gcc -O2 -fstack-usage -c ... uart_fmt.c -> uart_fmt.su
+   Usage: fmt_bench [calls per test (default 1000000)]
+          time: ns per call (and TSC ticks on x86),
+          stack: the highest stack usage of one call on a painted stack (the stack of an empty call is subtracted),
+          the outputs of the two functions are compared
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ucontext.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "main.h"
+#include "uart_fmt.h"
+
+namespace {
+
+typedef int (*FmtFn)(char * buf, unsigned int size);
+
+/* the same format and arguments with uart_snprintf and snprintf */
+#define  FMT_CASE(name, ...)                                                        \
+  { name, [](char * b, unsigned int n) { return uart_snprintf(b, n, __VA_ARGS__); }, \
+          [](char * b, unsigned int n) { return snprintf(b, n, __VA_ARGS__); } }
+
+struct Case
+{
+  const char * name;
+  FmtFn uart;
+  FmtFn libc;
+};
+
+const Case cases[] = {
+  FMT_CASE("%d", "%d", -12345),
+  FMT_CASE("%s", "%s", "hello world"),
+  FMT_CASE("%08X", "%08X", 0xBEEFu),
+  FMT_CASE("%lld", "%lld", -1234567890123LL),
+  FMT_CASE("%.3f", "%.3f", 3.25),
+  FMT_CASE("log line", "[%8u] adc ch%u: %5d mV (%s) 0x%04x %c", 123456u, 3u, -1250, "ok", 0x1A2Bu, 'R'),
+  FMT_CASE("sensor", "t=%+.2f C rh=%.1f %% p=%lu Pa", -12.5, 45.75, 101325ul),
+};
+
+double now_s()
+{
+  using namespace std::chrono;
+  return duration_cast<duration<double> >(steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t ticks()
+{
+  #if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+  #else
+  return 0;
+  #endif
+}
+
+/* painted stack: the function is called on its own stack, the untouched part is counted */
+const size_t STACK = 64 * 1024;
+const unsigned char PAINT = 0xA5;
+unsigned char stack[STACK];
+ucontext_t main_ctx, run_ctx;
+FmtFn run_fn;
+char run_out[256];
+
+void run_call()
+{
+  if(run_fn)
+    run_fn(run_out, sizeof(run_out));
+}
+
+size_t stack_used(FmtFn f)
+{
+  memset(stack, PAINT, sizeof(stack));
+  run_fn = f;
+  getcontext(&run_ctx);
+  run_ctx.uc_stack.ss_sp = stack;
+  run_ctx.uc_stack.ss_size = sizeof(stack);
+  run_ctx.uc_link = &main_ctx;
+  makecontext(&run_ctx, run_call, 0);
+  swapcontext(&main_ctx, &run_ctx);
+  size_t i = 0;
+  while(i < sizeof(stack) && stack[i] == PAINT)
+    i++;
+  return sizeof(stack) - i;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  unsigned long calls = argc > 1 ? strtoul(argv[1], 0, 0) : 1000000;
+  size_t base = stack_used(0);
+  bool ok = true;
+  char b1[256], b2[256];
+
+  printf("%-10s %10s %10s %10s %10s %10s %10s\n", "format", "uart ns", "libc ns", "uart tsc", "libc tsc", "uart stack", "libc stack");
+  for(const Case & c : cases)
+  {
+    int n1 = c.uart(b1, sizeof(b1)), n2 = c.libc(b2, sizeof(b2));
+    if(n1 != n2 || strcmp(b1, b2))
+    {
+      printf("%-10s output differs: \"%s\" / \"%s\"\n", c.name, b1, b2);
+      ok = false;
+    }
+
+    double t[2];
+    uint64_t k[2];
+    FmtFn f[2] = { c.uart, c.libc };
+    for(int m = 0; m < 2; m++)
+    {
+      volatile int sink = 0;
+      double t0 = now_s();
+      uint64_t k0 = ticks();
+      for(unsigned long i = 0; i < calls; i++)
+        sink += f[m](b1, sizeof(b1));
+      k[m] = ticks() - k0;
+      t[m] = now_s() - t0;
+      (void)sink;
+    }
+
+    printf("%-10s %10.1f %10.1f %10.0f %10.0f %10zu %10zu\n", c.name, t[0] / calls * 1e9, t[1] / calls * 1e9,
+           (double)k[0] / calls, (double)k[1] / calls, stack_used(c.uart) - base, stack_used(c.libc) - base);
+  }
+  printf("%s\n", ok ? "outputs equal" : "OUTPUT DIFFERS");
+  return ok ? 0 : 1;
+}
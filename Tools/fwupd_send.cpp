@@ -0,0 +1,242 @@
+/* Host side sender of the streaming firmware update (Drivers/protocol/fwupd.h)
+
+   Build: g++ -std=c++11 -O2 -o fwupd_send fwupd_send.cpp
+   Usage: fwupd_send <image file> <serial device> [baud rate] [timeout ms]
+          the transfer starts (or resumes) at the offset given by the device,
+          timeout: no answer -> query again (longer than the erase time of a flash sector, default 3000)
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+const unsigned int BLOCK   = 1024;      /* FWUPD_BLOCK */
+const unsigned int RETRIES = 10;
+
+uint32_t now_ms()
+{
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t crc32(const unsigned char * p, size_t n)
+{
+  static uint32_t t[256];
+  if(!t[1])
+    for(uint32_t i = 0; i < 256; i++)
+    {
+      uint32_t c = i;
+      for(int k = 0; k < 8; k++)
+        c = (c >> 1) ^ ((c & 1) ? 0xEDB88320 : 0);
+      t[i] = c;
+    }
+  uint32_t c = 0xFFFFFFFF;
+  while(n--)
+    c = (c >> 8) ^ t[(c ^ *p++) & 0xFF];
+  return ~c;
+}
+
+uint32_t get(const std::vector<unsigned char> & f, size_t i, unsigned int n)
+{
+  uint32_t v = 0;
+  while(n--)
+    v = (v << 8) | f[i + n];
+  return v;
+}
+
+void put(std::vector<unsigned char> & f, uint32_t v, unsigned int n)
+{
+  for(unsigned int i = 0; i < n; i++)
+    f.push_back((unsigned char)(v >> (8 * i)));
+}
+
+bool decode(const std::vector<unsigned char> & in, std::vector<unsigned char> & out)
+{
+  size_t i = 0;
+  while(i < in.size())
+  {
+    unsigned char code = in[i++];
+    if(i + code - 1 > in.size())
+      return false;
+    out.insert(out.end(), in.begin() + i, in.begin() + i + code - 1);
+    i += code - 1;
+    if(code != 0xFF && i < in.size())
+      out.push_back(0);
+  }
+  return !out.empty();
+}
+
+void send(int fd, std::vector<unsigned char> f)
+{
+  put(f, crc32(f.data(), f.size()), 4);
+  std::vector<unsigned char> e(1, 0);
+  size_t cp = 0;
+  unsigned char code = 1;
+  for(size_t i = 0; i < f.size(); i++)
+  {
+    if(f[i])
+    {
+      e.push_back(f[i]);
+      code++;
+    }
+    if(!f[i] || (code == 0xFF && i + 1 < f.size()))
+    {
+      e[cp] = code;
+      cp = e.size();
+      e.push_back(0);
+      code = 1;
+    }
+  }
+  e[cp] = code;
+  e.push_back(0);
+  for(size_t n = 0; n < e.size();)
+  {
+    ssize_t r = write(fd, e.data() + n, e.size() - n);
+    if(r > 0)
+      n += r;
+    else if(r < 0 && errno != EINTR && errno != EAGAIN)
+      return;
+  }
+}
+
+speed_t baudrate(long b)
+{
+  switch(b)
+  {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 2000000: return B2000000;
+    default: return B115200;
+  }
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  if(argc < 3)
+  {
+    fprintf(stderr, "usage: %s <image file> <serial device> [baud rate] [timeout ms]\n", argv[0]);
+    return 1;
+  }
+
+  FILE * file = fopen(argv[1], "rb");
+  if(!file)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+  std::vector<unsigned char> img;
+  unsigned char buf[4096];
+  size_t r;
+  while((r = fread(buf, 1, sizeof(buf), file)) > 0)
+    img.insert(img.end(), buf, buf + r);
+  fclose(file);
+
+  int fd = open(argv[2], O_RDWR | O_NOCTTY);
+  if(fd < 0)
+  {
+    perror(argv[2]);
+    return 1;
+  }
+  termios t;
+  if(tcgetattr(fd, &t) == 0)
+  {
+    cfmakeraw(&t);
+    speed_t s = baudrate(argc > 3 ? atol(argv[3]) : 115200);
+    cfsetispeed(&t, s);
+    cfsetospeed(&t, s);
+    tcsetattr(fd, TCSANOW, &t);
+  }
+  uint32_t timeout = argc > 4 ? atol(argv[4]) : 3000;
+
+  /* one block for every 'K' of the device, 'Q' after timeout */
+  uint32_t t0 = now_ms(), tsent = t0 - timeout, start = 0xFFFFFFFF;
+  unsigned int retry = 0, blocks = 0;
+  int result = -1;
+  std::vector<unsigned char> raw;
+  while(result < 0)
+  {
+    if(now_ms() - tsent >= timeout)
+    {
+      if(++retry > RETRIES + 1)
+      {
+        fprintf(stderr, "no answer\n");
+        break;
+      }
+      send(fd, std::vector<unsigned char>(1, 'Q'));
+      tsent = now_ms();
+    }
+    pollfd p = { fd, POLLIN, 0 };
+    if(poll(&p, 1, 10) < 0 && errno != EINTR)
+      break;
+    if(!(p.revents & POLLIN))
+      continue;
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if(n <= 0)
+      break;
+    for(ssize_t i = 0; i < n; i++)
+    {
+      if(buf[i])
+      {
+        raw.push_back(buf[i]);
+        continue;
+      }
+      std::vector<unsigned char> f;
+      bool ok = decode(raw, f) && f.size() >= 5 && crc32(f.data(), f.size() - 4) == get(f, f.size() - 4, 4);
+      raw.clear();
+      if(!ok)
+        continue;
+      if(f[0] == 'K' && f.size() == 9)
+      {
+        uint32_t ofs = get(f, 1, 4);
+        if(start == 0xFFFFFFFF)
+          start = ofs;
+        std::vector<unsigned char> d(1, ofs >= img.size() ? 'F' : 'D');
+        if(ofs >= img.size())
+        {
+          put(d, (uint32_t)img.size(), 4);
+          put(d, crc32(img.data(), img.size()), 4);
+        }
+        else
+        {
+          size_t len = std::min<size_t>(BLOCK, img.size() - ofs);
+          put(d, ofs, 4);
+          d.insert(d.end(), img.begin() + ofs, img.begin() + ofs + len);
+          blocks++;
+          fprintf(stderr, "\r%lu / %lu", (unsigned long)ofs + len, (unsigned long)img.size());
+        }
+        send(fd, d);
+        tsent = now_ms();
+        retry = 0;
+      }
+      else if(f[0] == 'R' && f.size() == 6)
+        result = f[1];
+    }
+  }
+  close(fd);
+
+  double s = (now_ms() - t0) / 1000.0;
+  fprintf(stderr, "\n%s, start offset: %lu, %u blocks sent in %.2f s (%.0f bytes/s)\n",
+          result == 1 ? "image ok" : result == 0 ? "image crc error" : "failed",
+          (unsigned long)(start == 0xFFFFFFFF ? 0 : start), blocks, s,
+          s > 0 ? (img.size() - (start == 0xFFFFFFFF ? 0 : start)) / s : 0.0);
+  return result == 1 ? 0 : 1;
+}
@@ -0,0 +1,16 @@
+/* main.h for the host builds of the protocol layers (Tools benchmarks)
+   it replaces the main.h of the stm32 project: CMSIS intrinsics used by Drivers/protocol
+   example: gcc -O2 -c -I host -I ../Drivers/stm32f4xx -I ../Drivers/protocol ../Drivers/protocol/cobs.c */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+
+#define __weak  __attribute__((weak))
+#define __DMB()
+
+/* always in thread mode */
+static inline uint32_t __get_IPSR(void) { return 0; }
+
+#endif /* __MAIN_H */
@@ -0,0 +1,103 @@
+/* Host side decompressor of the streaming LZSS compressor (Drivers/protocol/lz.h)
+
+   Build: g++ -std=c++11 -O2 -o lz_decode lz_decode.cpp
+   Usage: lz_decode [compressed file or serial device (default: stdin)]
+          the decompressed stream is written to stdout,
+          a stream reset (group lost on the device) is reported on stderr
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+class LzDecoder
+{
+public:
+  LzDecoder() : win_(4096), pos_(0), flag_(0), item_(8), lo_(0), state_(0) {}
+
+  /* process one compressed character, the decompressed characters are written to out */
+  void put(unsigned char c, FILE * out)
+  {
+    if(state_ == 0)
+    {                                   /* flag character */
+      flag_ = c;
+      item_ = 0;
+      state_ = 1;
+      return;
+    }
+    if(state_ == 2)
+    {                                   /* second character of a match */
+      unsigned int d = lo_ | ((c & 0xF0) << 4);
+      unsigned int n = (c & 0x0F) + 3;
+      state_ = 1;
+      if(d == 0)
+      {                                 /* end of the group (flush) or reset (lost group) */
+        if(n - 3 == 1)
+        {
+          pos_ = 0;
+          std::fill(win_.begin(), win_.end(), 0);
+          fprintf(stderr, "lz_decode: stream reset, characters lost\n");
+        }
+        state_ = 0;
+        return;
+      }
+      for(unsigned int i = 0; i < n; i++)
+        emit(win_[(pos_ - d) & 4095], out);
+      next();
+      return;
+    }
+    if(flag_ & (1 << item_))
+    {                                   /* first character of a match */
+      lo_ = c;
+      state_ = 2;
+      return;
+    }
+    emit(c, out);                       /* literal */
+    next();
+  }
+
+private:
+  void emit(unsigned char c, FILE * out)
+  {
+    win_[pos_++ & 4095] = c;
+    fputc(c, out);
+  }
+
+  void next()
+  {
+    if(++item_ == 8)
+      state_ = 0;
+  }
+
+  std::vector<unsigned char> win_;
+  unsigned int pos_;
+  unsigned char flag_;
+  unsigned int item_;
+  unsigned int lo_;
+  int state_;                           /* 0 = flag, 1 = item, 2 = second character of a match */
+};
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  FILE * in = stdin;
+  if(argc > 1 && !(in = fopen(argv[1], "rb")))
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  LzDecoder d;
+  int c;
+  while((c = fgetc(in)) != EOF)
+  {
+    d.put((unsigned char)c, stdout);
+    if(in == stdin)
+      fflush(stdout);                   /* live stream */
+  }
+  fflush(stdout);
+  return 0;
+}
@@ -0,0 +1,375 @@
+/* Host interleaving model of the TX path of the uart driver (uartx.h: uartx_send, uartx_send_urgent,
+   txx_commit and the TX part of the uart interrupt)
+
+   Build: g++ -std=c++11 -O2 -o tx_model tx_model.cpp
+   Usage: tx_model [mutation]
+          every interleaving of a thread producer, an interrupt producer and the uart interrupt is explored
+          (both priority orders of the two interrupts), every shared memory access is a separate step,
+          the LDREX/STREX loops are atomic steps, TXE can rise at any time
+          checked: no open reservation -> all reserved areas are published and the uart interrupt is enabled
+          or pending if there is something to send (no lost kick), at the end both buffers are sent out
+          mutation 1: the old uartx_send_urgent (a failed reservation closes without publishing)
+          mutation 2: the uart interrupt stops the TX without checking the buffers again
+          (the model has to find a counterexample for both)
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const unsigned int SIZE = 4;            /* TXBUFX_SIZE and URGBUFX_SIZE */
+
+int mutation = 0;
+
+struct Op {
+  bool urgent;                          /* uartx_send_urgent / uartx_send */
+  unsigned int len;
+};
+
+struct Scenario {
+  const char * name;
+  std::vector<Op> thread;               /* called one after the other from the main program */
+  std::vector<Op> isr;                  /* one op per activation of the interrupt producer */
+};
+
+enum { R_NEST, R_RES, R_MARK, C_DEC, C_READRES, C_MAX, C_READRESTART, C_PEND, W_CHECK, P_DONE };
+enum { I_UIN, I_TIN1, I_USEND, I_UREST, I_UTXEIE, I_TIN2, I_TSEND, I_TREST, I_TTXEIE,
+       I_STOP, I_STOPTXEIE, I_CHKT, I_CHKU, I_PEND };
+
+struct Buf {
+  uint8_t in, out, res, nest;
+};
+
+/* a producer context (main program or interrupt) */
+struct Prod {
+  uint8_t active, pc, op, pos, n, r, fail;
+};
+
+struct State {
+  Buf t, u;                             /* tbufx, ubufx */
+  uint8_t cont;                         /* tbufx.cont */
+  uint8_t restart, txeie, pend;         /* txx_restart, USART_CR1_TXEIE, NVIC pending bit */
+  uint8_t urgent, inmsg;                /* txx_urgent, txx_inmsg */
+  Prod th, ip;                          /* thread, interrupt producer */
+  uint8_t ipused;                       /* activations of the interrupt producer */
+  uint8_t ua, upc, ur;                  /* uart interrupt: active, pc, read value */
+
+  bool operator==(const State & s) const { return !memcmp(this, &s, sizeof(State)); }
+};
+
+struct Hash {
+  size_t operator()(const State & s) const
+  {
+    const unsigned char * p = (const unsigned char *)&s;
+    size_t h = 14695981039346656037ULL;
+    for(size_t i = 0; i < sizeof(State); i++)
+      h = (h ^ p[i]) * 1099511628211ULL;
+    return h;
+  }
+};
+
+class Model {
+public:
+  Model(const Scenario & sc, bool uarthigh) : sc(sc), uarthigh(uarthigh) { }
+  bool run();
+
+private:
+  const Scenario & sc;
+  bool uarthigh;                        /* uart interrupt priority above the interrupt producer */
+  std::vector<State> states;
+  std::vector<int> parent;
+  std::vector<std::string> label;
+
+  int prio_ip() const { return uarthigh ? 1 : 2; }
+  int prio_u() const { return uarthigh ? 2 : 1; }
+  int top(const State & s) const;
+  std::string prod_step(State & s, Prod & c, const std::vector<Op> & ops, bool isr);
+  std::string uart_step(State & s);
+  const char * check(const State & s, bool final) const;
+  void trace(int i, const char * err) const;
+};
+
+/* priority of the running context (0: thread, -1: nothing runs) */
+int Model::top(const State & s) const
+{
+  int p = s.th.pc == P_DONE ? -1 : 0;
+  if(s.ip.active && prio_ip() > p)
+    p = prio_ip();
+  if(s.ua && prio_u() > p)
+    p = prio_u();
+  return p;
+}
+
+std::string Model::prod_step(State & s, Prod & c, const std::vector<Op> & ops, bool isr)
+{
+  const Op & op = ops[c.op];
+  Buf & b = op.urgent ? s.u : s.t;
+  std::string l = std::string(isr ? "ip" : "th") + (op.urgent ? " urgent: " : " send: ");
+  switch(c.pc)
+  {
+    case R_NEST:
+      b.nest++;
+      c.pc = R_RES;
+      return l + "nest++";
+    case R_RES:
+      if((uint8_t)(b.res + op.len - b.out) <= SIZE)
+      {
+        c.pos = b.res;
+        b.res += op.len;
+        c.fail = 0;
+        c.pc = op.urgent ? C_DEC : R_MARK;
+        return l + "reserve ok";
+      }
+      c.fail = 1;
+      c.pc = C_DEC;
+      return l + "reserve failed";
+    case R_MARK:                        /* txx_msgmark */
+      for(unsigned int i = 0; i < op.len; i++)
+      {
+        unsigned int bit = 1 << ((c.pos + i) & (SIZE - 1));
+        s.cont = (i + 1 < op.len) ? (s.cont | bit) : (s.cont & ~bit);
+      }
+      c.pc = C_DEC;
+      return l + "msgmark";
+    case C_DEC:                         /* txx_commit */
+      c.n = --b.nest;
+      if(mutation == 1 && op.urgent && c.fail)
+        c.pc = W_CHECK;
+      else
+        c.pc = c.n ? (c.fail ? W_CHECK : P_DONE) : C_READRES;
+      return l + "nest--";
+    case C_READRES:
+      c.r = b.res;
+      c.pc = C_MAX;
+      return l + "read res";
+    case C_MAX:
+      if((int8_t)(c.r - b.in) > 0)
+        b.in = c.r;
+      c.pc = C_READRESTART;
+      return l + "atomic max in";
+    case C_READRESTART:
+      c.pc = s.restart ? C_PEND : (c.fail ? W_CHECK : P_DONE);
+      return l + (s.restart ? "txx_restart = 1" : "txx_restart = 0");
+    case C_PEND:
+      s.pend = 1;
+      c.pc = c.fail ? W_CHECK : P_DONE;
+      return l + "pend";
+    case W_CHECK:                       /* in interrupt or with open reservation: give up, else wait */
+      if((op.urgent ? c.n : s.t.nest) || isr)
+        c.pc = P_DONE;
+      else
+        c.pc = R_NEST;
+      return l + (c.pc == P_DONE ? "give up" : "retry");
+  }
+  return l;
+}
+
+std::string Model::uart_step(State & s)
+{
+  switch(s.upc)
+  {
+    case I_UIN:
+      s.ur = s.u.in;
+      s.upc = (s.ur == s.u.out) ? I_TIN2 : (s.urgent || !s.inmsg) ? I_USEND : I_TIN1;
+      return "uart: read ubufx.in";
+    case I_TIN1:
+      s.upc = (s.t.in == s.t.out) ? I_USEND : I_TIN2;
+      return "uart: read tbufx.in";
+    case I_USEND:
+      s.u.out++;
+      s.urgent = 1;
+      s.upc = s.restart ? I_UREST : 0xFF;
+      return "uart: send urgent";
+    case I_UREST:
+    case I_TREST:
+      s.restart = 0;
+      s.upc++;
+      return "uart: txx_restart = 0";
+    case I_UTXEIE:
+    case I_TTXEIE:
+      s.txeie = 1;
+      s.upc = 0xFF;
+      return "uart: TXEIE = 1";
+    case I_TIN2:
+      s.ur = s.t.in;
+      s.upc = (s.ur != s.t.out) ? I_TSEND : s.restart ? 0xFF : I_STOP;
+      return "uart: read tbufx.in";
+    case I_TSEND:
+      s.urgent = 0;
+      s.inmsg = (s.cont >> (s.t.out & (SIZE - 1))) & 1;
+      s.t.out++;
+      s.upc = s.restart ? I_TREST : 0xFF;
+      return "uart: send";
+    case I_STOP:
+      s.restart = 1;
+      s.upc = I_STOPTXEIE;
+      return "uart: txx_restart = 1";
+    case I_STOPTXEIE:
+      s.txeie = 0;
+      s.upc = mutation == 2 ? 0xFF : I_CHKT;
+      return "uart: TXEIE = 0";
+    case I_CHKT:
+      s.upc = (s.t.in != s.t.out) ? I_PEND : I_CHKU;
+      return "uart: read tbufx.in";
+    case I_CHKU:
+      s.upc = (s.u.in != s.u.out) ? I_PEND : 0xFF;
+      return "uart: read ubufx.in";
+    case I_PEND:
+      s.pend = 1;
+      s.upc = 0xFF;
+      return "uart: pend";
+  }
+  return "uart";
+}
+
+/* the thread is between two calls (or waits for free space), the interrupts do not run */
+const char * Model::check(const State & s, bool final) const
+{
+  if(s.t.nest || s.u.nest)
+    return "open reservation";
+  if(s.t.in != s.t.res || s.u.in != s.u.res)
+    return "reserved area not published";
+  if(final && (s.t.in != s.t.out || s.u.in != s.u.out))
+    return "characters left in the buffer";
+  if((s.t.in != s.t.out || s.u.in != s.u.out) && !s.pend && !s.txeie)
+    return "lost kick: characters in the buffer, the uart interrupt is not enabled or pending";
+  return 0;
+}
+
+void Model::trace(int i, const char * err) const
+{
+  std::vector<int> path;
+  for(; i > 0; i = parent[i])
+    path.push_back(i);
+  printf("  counterexample (%s):\n", err);
+  for(size_t k = path.size(); k-- > 0;)
+    printf("    %s\n", label[path[k]].c_str());
+}
+
+bool Model::run()
+{
+  std::unordered_map<State, int, Hash> seen;
+  State s0;
+  memset(&s0, 0, sizeof(s0));
+  s0.restart = 1;
+  s0.th.active = 1;
+  s0.th.pc = sc.thread.empty() ? P_DONE : R_NEST;
+  states.assign(1, s0);
+  parent.assign(1, -1);
+  label.assign(1, "");
+  seen[s0] = 0;
+
+  for(size_t i = 0; i < states.size(); i++)   /* breadth first: the shortest counterexample */
+  {
+    const State s = states[i];
+    int p = top(s);
+    std::vector<std::pair<State, std::string> > next;
+
+    if(p == 0 && (s.th.pc == R_NEST || s.th.pc == P_DONE))
+    {
+      const char * err = check(s, false);
+      if(err)
+      {
+        trace((int)i, err);
+        return false;
+      }
+    }
+
+    if(p >= 0)
+    {                                   /* the running context makes a step */
+      State n = s;
+      std::string l;
+      if(p == prio_u() && s.ua)
+      {
+        l = uart_step(n);
+        if(n.upc == 0xFF)
+          n.ua = 0;
+      }
+      else if(p > 0)
+      {
+        l = prod_step(n, n.ip, sc.isr, true);
+        if(n.ip.pc == P_DONE)
+          n.ip.active = 0;
+      }
+      else
+      {
+        l = prod_step(n, n.th, sc.thread, false);
+        if(n.th.pc == P_DONE && ++n.th.op < sc.thread.size())
+          n.th.pc = R_NEST;
+      }
+      next.push_back(std::make_pair(n, l));
+    }
+    if(!s.ua && (s.pend || s.txeie) && prio_u() > p)
+    {                                   /* uart interrupt entry (clears the pending bit) */
+      State n = s;
+      n.ua = 1;
+      n.upc = I_UIN;
+      n.pend = 0;
+      next.push_back(std::make_pair(n, std::string(s.pend ? "uart: enter (pending)" : "uart: enter (TXE)")));
+    }
+    if(!s.ip.active && s.ipused < sc.isr.size() && prio_ip() > p)
+    {                                   /* interrupt producer entry */
+      State n = s;
+      n.ip.active = 1;
+      n.ip.pc = R_NEST;
+      n.ip.op = n.ipused++;
+      next.push_back(std::make_pair(n, std::string("ip: enter")));
+    }
+
+    if(next.empty())
+    {                                   /* everything finished */
+      const char * err = check(s, true);
+      if(err)
+      {
+        trace((int)i, err);
+        return false;
+      }
+    }
+    for(size_t k = 0; k < next.size(); k++)
+    {
+      if(seen.count(next[k].first))
+        continue;
+      seen[next[k].first] = (int)states.size();
+      states.push_back(next[k].first);
+      parent.push_back((int)i);
+      label.push_back(next[k].second);
+    }
+  }
+  printf("  %lu states ok\n", (unsigned long)states.size());
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  mutation = argc > 1 ? atoi(argv[1]) : 0;
+
+  const Op S1 = { false, 1 }, S2 = { false, 2 }, S3 = { false, 3 }, S4 = { false, 4 };
+  const Op U1 = { true, 1 }, U2 = { true, 2 }, U3 = { true, 3 };
+  const Scenario scenarios[] = {
+    { "send / send",        { S3, S2, S4, S1 },     { S2, S1 } },
+    { "urgent / urgent",    { U2, U3, U2, U1 },     { U2, U1 } },
+    { "send / urgent",      { S3, S2, S4, S1 },     { U2, U1 } },
+    { "urgent / send",      { U3, U2, U2 },         { S2, S3 } },
+    { "mixed / mixed",      { S3, U2, S2, U3, S1 }, { U1, S2, U2 } },
+  };
+
+  bool ok = true;
+  for(const Scenario & sc : scenarios)
+    for(int uarthigh = 1; uarthigh >= 0; uarthigh--)
+    {
+      printf("%s, uart interrupt %s the interrupt producer\n", sc.name, uarthigh ? "above" : "below");
+      Model m(sc, uarthigh != 0);
+      if(!m.run())
+        ok = false;
+    }
+  printf("%s\n", ok ? "no lost kick, no stall" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,290 @@
+/* Host side demultiplexer of the virtual channel multiplexer (Drivers/protocol/vmux.h)
+
+   Channel 0 (console): stdin -> device, device -> stdout
+   Channel 1..31: device -> file vmux_ch<n>.bin
+   The credits (absolute window edges) of all channels are sent again every REFRESH ms.
+
+   Build: g++ -std=c++11 -O2 -o vmux_demux vmux_demux.cpp
+   Usage: vmux_demux <serial device> [baud rate (default 115200)]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+const unsigned char VMUX_DATA   = 0x00;
+const unsigned char VMUX_CREDIT = 0x20;
+const unsigned char VMUX_TYPE   = 0xE0;
+const unsigned int  VMUX_CHMAX  = 32;
+const unsigned int  VMUX_CHUNK  = 32;
+const unsigned int  WINDOW      = 4096;  /* window given to the device on every channel */
+const unsigned int  REFRESH     = 100;   /* ms */
+
+uint32_t now_ms()
+{
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+class Demux
+{
+public:
+  explicit Demux(int fd) : fd_(fd), skip_(false), txpos_(VMUX_CHMAX, 0), txedge_(VMUX_CHMAX, 0),
+                           rxpos_(VMUX_CHMAX, 0), rxedge_(VMUX_CHMAX, 0), out_(VMUX_CHMAX, nullptr) {}
+
+  ~Demux()
+  {
+    for(unsigned int i = 1; i < VMUX_CHMAX; i++)
+      if(out_[i])
+        fclose(out_[i]);
+  }
+
+  /* initial credits (the device sends nothing without credit), also periodically (a lost credit
+     or a restarted device does not stall the channels) */
+  void refresh()
+  {
+    for(unsigned int ch = 0; ch < VMUX_CHMAX; ch++)
+      grant(ch);
+  }
+
+  /* received characters from the device */
+  void input(const unsigned char * p, size_t n)
+  {
+    for(size_t i = 0; i < n; i++)
+    {
+      if(p[i])
+      {
+        if(frame_.size() < 1024)
+          frame_.push_back(p[i]);
+        else
+          skip_ = true;
+        continue;
+      }
+      std::vector<unsigned char> f;
+      if(!skip_ && decode(frame_, f))
+        dispatch(f);
+      frame_.clear();
+      skip_ = false;
+    }
+  }
+
+  /* console input to channel 0 (only as much as the credit of the device) */
+  size_t console(const unsigned char * p, size_t n)
+  {
+    size_t sent = 0, credit;
+    while(sent < n && (credit = (txedge_[0] - txpos_[0]) & 0xFFFF))
+    {
+      size_t k = std::min<size_t>({n - sent, credit, VMUX_CHUNK});
+      std::vector<unsigned char> f = { (unsigned char)(VMUX_DATA | 0), (unsigned char)(txpos_[0] & 0xFF), (unsigned char)(txpos_[0] >> 8) };
+      f.insert(f.end(), p + sent, p + sent + k);
+      send(f);
+      txpos_[0] = (txpos_[0] + k) & 0xFFFF;
+      sent += k;
+    }
+    return sent;
+  }
+
+private:
+  static bool decode(const std::vector<unsigned char> & in, std::vector<unsigned char> & out)
+  {
+    size_t i = 0;
+    while(i < in.size())
+    {
+      unsigned char code = in[i++];
+      if(i + code - 1 > in.size())
+        return false;
+      out.insert(out.end(), in.begin() + i, in.begin() + i + code - 1);
+      i += code - 1;
+      if(code != 0xFF && i < in.size())
+        out.push_back(0);
+    }
+    return !out.empty();
+  }
+
+  static std::vector<unsigned char> encode(const std::vector<unsigned char> & in)
+  {
+    std::vector<unsigned char> out(1, 0);
+    size_t cp = 0;
+    unsigned char code = 1;
+    for(size_t i = 0; i < in.size(); i++)
+    {
+      if(in[i])
+      {
+        out.push_back(in[i]);
+        code++;
+      }
+      if(!in[i] || (code == 0xFF && i + 1 < in.size()))
+      {
+        out[cp] = code;
+        cp = out.size();
+        out.push_back(0);
+        code = 1;
+      }
+    }
+    out[cp] = code;
+    out.push_back(0);
+    return out;
+  }
+
+  void send(const std::vector<unsigned char> & f)
+  {
+    std::vector<unsigned char> e = encode(f);
+    size_t n = 0;
+    while(n < e.size())
+    {
+      ssize_t r = write(fd_, e.data() + n, e.size() - n);
+      if(r < 0 && errno != EINTR && errno != EAGAIN)
+        return;
+      if(r > 0)
+        n += r;
+    }
+  }
+
+  /* the received data is written out at once: the window edge is always WINDOW ahead */
+  void grant(unsigned int ch)
+  {
+    unsigned int edge = (rxpos_[ch] + WINDOW) & 0xFFFF;
+    std::vector<unsigned char> f = { (unsigned char)(VMUX_CREDIT | ch), (unsigned char)(rxpos_[ch] & 0xFF), (unsigned char)(rxpos_[ch] >> 8),
+                                     (unsigned char)(edge & 0xFF), (unsigned char)(edge >> 8) };
+    send(f);
+    rxedge_[ch] = edge;
+  }
+
+  void dispatch(const std::vector<unsigned char> & f)
+  {
+    unsigned int ch = f[0] & ~VMUX_TYPE;
+    if(f.size() < 3)
+      return;
+    unsigned int pos = f[1] | (f[2] << 8);
+    if((f[0] & VMUX_TYPE) == VMUX_CREDIT && f.size() == 5)
+    {
+      unsigned int edge = f[3] | (f[4] << 8);
+      if(((txpos_[ch] - pos) & 0xFFFF) > ((edge - pos) & 0xFFFF))
+        txpos_[ch] = pos;               /* beyond the window: the device was restarted */
+      txedge_[ch] = edge;
+    }
+    else if((f[0] & VMUX_TYPE) == VMUX_DATA)
+    {
+      if(pos != rxpos_[ch])
+      {
+        fprintf(stderr, "vmux channel %u: %u characters lost (or the device was restarted)\n", ch, (pos - rxpos_[ch]) & 0xFFFF);
+        rxpos_[ch] = pos;
+      }
+      rxpos_[ch] = (rxpos_[ch] + f.size() - 3) & 0xFFFF;
+      FILE * o = stdout;
+      if(ch)
+      {
+        if(!out_[ch])
+          out_[ch] = fopen(("vmux_ch" + std::to_string(ch) + ".bin").c_str(), "ab");
+        o = out_[ch];
+      }
+      if(o)
+      {
+        fwrite(f.data() + 3, 1, f.size() - 3, o);
+        fflush(o);
+      }
+      if((((rxpos_[ch] + WINDOW) - rxedge_[ch]) & 0xFFFF) >= WINDOW / 4)
+        grant(ch);
+    }
+  }
+
+  int fd_;
+  bool skip_;
+  std::vector<unsigned char> frame_;
+  std::vector<unsigned int> txpos_;     /* stream position of the next sent character (16 bit) */
+  std::vector<unsigned int> txedge_;    /* window edge of the device */
+  std::vector<unsigned int> rxpos_;     /* stream position of the next received character */
+  std::vector<unsigned int> rxedge_;    /* the last window edge sent to the device */
+  std::vector<FILE *> out_;
+};
+
+speed_t baudrate(long b)
+{
+  switch(b)
+  {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return B115200;
+  }
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  if(argc < 2)
+  {
+    fprintf(stderr, "usage: %s <serial device> [baud rate]\n", argv[0]);
+    return 1;
+  }
+
+  int fd = open(argv[1], O_RDWR | O_NOCTTY);
+  if(fd < 0)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+  termios t;
+  if(tcgetattr(fd, &t) == 0)
+  {
+    cfmakeraw(&t);
+    speed_t s = baudrate(argc > 2 ? atol(argv[2]) : 115200);
+    cfsetispeed(&t, s);
+    cfsetospeed(&t, s);
+    tcsetattr(fd, TCSANOW, &t);
+  }
+
+  Demux mux(fd);
+  mux.refresh();
+  uint32_t trefresh = now_ms();
+
+  std::vector<unsigned char> pending;   /* console characters without credit */
+  unsigned char buf[512];
+  pollfd p[2] = { { fd, POLLIN, 0 }, { STDIN_FILENO, POLLIN, 0 } };
+  for(;;)
+  {
+    if(poll(p, 2, 100) < 0 && errno != EINTR)
+      break;
+    if(p[0].revents & POLLIN)
+    {
+      ssize_t n = read(fd, buf, sizeof(buf));
+      if(n <= 0)
+        break;
+      mux.input(buf, n);
+    }
+    if((p[1].revents & POLLIN) && pending.size() < 4096)
+    {
+      ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+      if(n > 0)
+        pending.insert(pending.end(), buf, buf + n);
+      else
+        p[1].fd = -1;                   /* end of stdin */
+    }
+    if(!pending.empty())
+      pending.erase(pending.begin(), pending.begin() + mux.console(pending.data(), pending.size()));
+    if(now_ms() - trefresh >= REFRESH)
+    {
+      mux.refresh();
+      trefresh = now_ms();
+    }
+  }
+  close(fd);
+  return 0;
+}
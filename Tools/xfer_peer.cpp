@@ -0,0 +1,432 @@
+/* Host side peer of the sliding window file transfer (Drivers/protocol/xfer.h)
+
+   Build: g++ -std=c++11 -O2 -o xfer_peer xfer_peer.cpp
+   Usage: xfer_peer send <file> <serial device | -p> [baud rate]
+          xfer_peer recv <file> <serial device | -p> [baud rate]
+          -p: a pseudo terminal is opened, its name is printed (for testing, e.g. two xfer_peer
+              or a simulator on the two ends: xfer_peer recv out.bin -p, xfer_peer send in.bin /dev/pts/N)
+*/
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+const unsigned int BLOCK   = 1024;
+const unsigned int WINDOW  = 8;
+const unsigned int RTO     = 500;       /* ms */
+const unsigned int RETRIES = 10;
+
+uint32_t now_ms()
+{
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t crc32(const unsigned char * p, size_t n)
+{
+  static uint32_t t[256];
+  if(!t[1])
+    for(uint32_t i = 0; i < 256; i++)
+    {
+      uint32_t c = i;
+      for(int k = 0; k < 8; k++)
+        c = (c >> 1) ^ ((c & 1) ? 0xEDB88320 : 0);
+      t[i] = c;
+    }
+  uint32_t c = 0xFFFFFFFF;
+  while(n--)
+    c = (c >> 8) ^ t[(c ^ *p++) & 0xFF];
+  return ~c;
+}
+
+uint32_t get(const std::vector<unsigned char> & f, size_t i, unsigned int n)
+{
+  uint32_t v = 0;
+  while(n--)
+    v = (v << 8) | f[i + n];
+  return v;
+}
+
+void put(std::vector<unsigned char> & f, uint32_t v, unsigned int n)
+{
+  for(unsigned int i = 0; i < n; i++)
+    f.push_back((unsigned char)(v >> (8 * i)));
+}
+
+class Peer
+{
+public:
+  Peer(int fd, FILE * file, bool sender) : fd_(fd), file_(file), sender_(sender) {}
+
+  bool run()
+  {
+    if(sender_)
+    {
+      fseek(file_, 0, SEEK_END);
+      size_ = ftell(file_);
+      n_ = (size_ + BLOCK - 1) / BLOCK;
+      state_ = 1;
+      ttime_ = now_ms() - RTO;
+    }
+    uint32_t t0 = now_ms();
+    std::vector<unsigned char> raw;
+    unsigned char buf[4096];
+    while(!finished_)
+    {
+      pollfd p = { fd_, POLLIN, 0 };
+      if(poll(&p, 1, 10) < 0 && errno != EINTR)
+        return false;
+      if(p.revents & POLLIN)
+      {
+        ssize_t r = read(fd_, buf, sizeof(buf));
+        if(r <= 0)
+          return false;
+        for(ssize_t i = 0; i < r; i++)
+        {
+          if(buf[i])
+          {
+            raw.push_back(buf[i]);
+            continue;
+          }
+          std::vector<unsigned char> f;
+          if(decode(raw, f))
+            frame(f);
+          raw.clear();
+        }
+      }
+      if(rack_)
+      {
+        std::vector<unsigned char> a(1, 'A');
+        put(a, rbase_, 2);
+        put(a, rbits_, 4);
+        send(a);
+        rack_ = false;
+      }
+      if(sender_ && !tpoll())
+        return false;
+    }
+    double s = (now_ms() - t0) / 1000.0;
+    fprintf(stderr, "%s %lu bytes in %.2f s (%.0f bytes/s), retransmits: %u, broken frames: %u\n",
+            sender_ ? "sent" : "received", (unsigned long)(sender_ ? size_ : rsize_), s,
+            s > 0 ? (sender_ ? size_ : rsize_) / s : 0.0, retrans_, crcerr_);
+    return ok_;
+  }
+
+private:
+  static bool decode(const std::vector<unsigned char> & in, std::vector<unsigned char> & out)
+  {
+    size_t i = 0;
+    while(i < in.size())
+    {
+      unsigned char code = in[i++];
+      if(i + code - 1 > in.size())
+        return false;
+      out.insert(out.end(), in.begin() + i, in.begin() + i + code - 1);
+      i += code - 1;
+      if(code != 0xFF && i < in.size())
+        out.push_back(0);
+    }
+    return !out.empty();
+  }
+
+  void send(std::vector<unsigned char> f)
+  {
+    put(f, crc32(f.data(), f.size()), 4);
+    std::vector<unsigned char> e(1, 0);
+    size_t cp = 0;
+    unsigned char code = 1;
+    for(size_t i = 0; i < f.size(); i++)
+    {
+      if(f[i])
+      {
+        e.push_back(f[i]);
+        code++;
+      }
+      if(!f[i] || (code == 0xFF && i + 1 < f.size()))
+      {
+        e[cp] = code;
+        cp = e.size();
+        e.push_back(0);
+        code = 1;
+      }
+    }
+    e[cp] = code;
+    e.push_back(0);
+    for(size_t n = 0; n < e.size();)
+    {
+      ssize_t r = write(fd_, e.data() + n, e.size() - n);
+      if(r > 0)
+        n += r;
+      else if(r < 0 && errno != EINTR && errno != EAGAIN)
+        return;
+    }
+  }
+
+  void block(uint32_t b)
+  {
+    std::vector<unsigned char> f(1, 'D');
+    put(f, b, 2);
+    size_t len = std::min<size_t>(BLOCK, size_ - (size_t)b * BLOCK);
+    f.resize(3 + len);
+    fseek(file_, (long)b * BLOCK, SEEK_SET);
+    if(fread(f.data() + 3, 1, len, file_) != len)
+      return;
+    send(f);
+    tsent_[b % WINDOW] = now_ms();
+  }
+
+  bool tpoll()
+  {
+    uint32_t t = now_ms();
+    if(state_ == 1 || state_ == 3)
+    {
+      if(t - ttime_ < RTO)
+        return true;
+      if(++tretry_ > RETRIES + 1)
+        return false;
+      std::vector<unsigned char> f(1, state_ == 1 ? 'S' : 'E');
+      if(state_ == 1)
+        put(f, size_, 4);
+      send(f);
+      ttime_ = t;
+      return true;
+    }
+    for(uint32_t i = 0; i < tnext_ - tbase_; i++)
+    {
+      uint32_t m = 1u << i;
+      if(tacked_ & m)
+        continue;
+      if(!(tresend_ & m) && t - tsent_[(tbase_ + i) % WINDOW] < RTO)
+        continue;
+      if(!(tresend_ & m) && i == 0 && ++tretry_ > RETRIES)
+        return false;
+      block(tbase_ + i);
+      tresend_ &= ~m;
+      retrans_++;
+    }
+    while(tnext_ < n_ && tnext_ - tbase_ < WINDOW)
+      block(tnext_++);
+    return true;
+  }
+
+  void ack(uint32_t base16, uint32_t bits)
+  {
+    uint32_t base = tbase_ + (int16_t)(base16 - (uint16_t)tbase_);
+    if(state_ == 1)
+    {
+      if(base16)
+        return;
+      state_ = 2;
+      tretry_ = 0;
+    }
+    if(state_ == 3)
+    {
+      if(base == n_)
+        ok_ = finished_ = true;
+      return;
+    }
+    if(state_ != 2 || (int32_t)(base - tbase_) < 0 || (int32_t)(base - tnext_) > 0)
+      return;
+    if(base != tbase_)
+    {
+      uint32_t sh = base - tbase_;
+      tacked_ >>= sh;
+      tfast_ >>= sh;
+      tresend_ >>= sh;
+      tbase_ = base;
+      tretry_ = 0;
+    }
+    tacked_ |= (bits << 1) & ((1u << (tnext_ - tbase_)) - 1);
+    int h = WINDOW - 1;
+    while(h > 0 && !(tacked_ & (1u << h)))
+      h--;
+    for(int i = 0; i < h; i++)
+      if(!(tacked_ & (1u << i)) && !(tfast_ & (1u << i)))
+      {
+        tfast_ |= 1u << i;
+        tresend_ |= 1u << i;
+      }
+    if(tbase_ == n_)
+    {
+      state_ = 3;
+      ttime_ = now_ms() - RTO;
+      tretry_ = 0;
+    }
+  }
+
+  void data(const std::vector<unsigned char> & f, size_t len)
+  {
+    uint32_t blk = rbase_ + (int16_t)(get(f, 1, 2) - (uint16_t)rbase_);
+    uint32_t rel = blk - rbase_;
+    rack_ = true;
+    if(!rstate_ || (int32_t)rel < 0 || rel > 32 || blk >= rn_)
+      return;
+    if(rel && (rbits_ & (1u << (rel - 1))))
+      return;
+    if(len - 3 != (blk == rn_ - 1 ? rsize_ - (size_t)blk * BLOCK : BLOCK))
+    {
+      crcerr_++;
+      return;
+    }
+    fseek(file_, (long)blk * BLOCK, SEEK_SET);
+    fwrite(f.data() + 3, 1, len - 3, file_);
+    if(rel)
+      rbits_ |= 1u << (rel - 1);
+    else
+    {
+      rbase_++;
+      while(rbits_ & 1)
+      {
+        rbits_ >>= 1;
+        rbase_++;
+      }
+      rbits_ >>= 1;
+    }
+  }
+
+  void frame(const std::vector<unsigned char> & f)
+  {
+    if(f.size() < 5)
+    {
+      crcerr_++;
+      return;
+    }
+    size_t len = f.size() - 4;
+    if(crc32(f.data(), len) != get(f, len, 4))
+    {
+      crcerr_++;
+      return;
+    }
+    switch(f[0])
+    {
+      case 'S':
+        if(len != 5 || sender_)
+          break;
+        if(!(rstate_ && rsize_ == get(f, 1, 4) && !rbase_ && !rbits_))
+        {
+          rstate_ = true;
+          rsize_ = get(f, 1, 4);
+          rn_ = (rsize_ + BLOCK - 1) / BLOCK;
+          rbase_ = rbits_ = 0;
+        }
+        rack_ = true;
+        break;
+      case 'D':
+        if(len >= 3 && !sender_)
+          data(f, len);
+        break;
+      case 'E':
+        if(sender_)
+          break;
+        if(rstate_ && rbase_ == rn_)
+        {
+          rstate_ = false;
+          ok_ = finished_ = true;
+        }
+        rack_ = true;
+        break;
+      case 'A':
+        if(len == 7 && sender_)
+          ack(get(f, 1, 2), get(f, 3, 4));
+        break;
+    }
+  }
+
+  int fd_;
+  FILE * file_;
+  bool sender_;
+  bool finished_ = false, ok_ = false;
+  unsigned int retrans_ = 0, crcerr_ = 0;
+
+  /* sender */
+  int state_ = 0;
+  size_t size_ = 0;
+  uint32_t n_ = 0, tbase_ = 0, tnext_ = 0, tacked_ = 0, tfast_ = 0, tresend_ = 0, ttime_ = 0;
+  uint32_t tsent_[WINDOW] = {};
+  unsigned int tretry_ = 0;
+
+  /* receiver */
+  bool rstate_ = false, rack_ = false;
+  uint32_t rsize_ = 0, rn_ = 0, rbase_ = 0, rbits_ = 0;
+};
+
+speed_t baudrate(long b)
+{
+  switch(b)
+  {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 2000000: return B2000000;
+    default: return B115200;
+  }
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  if(argc < 4 || (strcmp(argv[1], "send") && strcmp(argv[1], "recv")))
+  {
+    fprintf(stderr, "usage: %s send|recv <file> <serial device | -p> [baud rate]\n", argv[0]);
+    return 1;
+  }
+  bool sender = !strcmp(argv[1], "send");
+
+  FILE * file = fopen(argv[2], sender ? "rb" : "wb");
+  if(!file)
+  {
+    perror(argv[2]);
+    return 1;
+  }
+
+  int fd;
+  if(!strcmp(argv[3], "-p"))
+  {
+    fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if(fd < 0 || grantpt(fd) || unlockpt(fd))
+    {
+      perror("pty");
+      return 1;
+    }
+    printf("%s\n", ptsname(fd));
+    fflush(stdout);
+  }
+  else if((fd = open(argv[3], O_RDWR | O_NOCTTY)) < 0)
+  {
+    perror(argv[3]);
+    return 1;
+  }
+
+  termios t;
+  if(tcgetattr(fd, &t) == 0)
+  {
+    cfmakeraw(&t);
+    speed_t s = baudrate(argc > 4 ? atol(argv[4]) : 115200);
+    cfsetispeed(&t, s);
+    cfsetospeed(&t, s);
+    tcsetattr(fd, TCSANOW, &t);
+  }
+
+  Peer peer(fd, file, sender);
+  bool ok = peer.run();
+  fclose(file);
+  close(fd);
+  return ok ? 0 : 1;
+}